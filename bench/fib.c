@@ -0,0 +1,15 @@
+// Recursive Fibonacci: calls, returns and compares. // 遞迴費氏數列: 呼叫, 返回和比較
+
+#include <stdio.h>
+
+int fib(int n)
+{
+  if (n < 2) return n;
+  return fib(n - 1) + fib(n - 2);
+}
+
+int main()
+{
+  printf("%d\n", fib(30));
+  return 0;
+}
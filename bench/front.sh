@@ -0,0 +1,63 @@
+#!/usr/bin/env bash
+# Front end throughput benchmark for c4. // c4 的前端吞吐量效能測試
+#
+# usage: bench/front.sh [-n reps] [lines ...]
+#
+# Generates sources of the given sizes (default 10000 100000 1000000 lines)
+# with bench/gen.c, compiles each one `reps` times (default 3) with
+# `c4 --stats`, and reports the best wall time, tokens and lines per second,
+# the number of symbols and the average hash probes per lookup. The generated
+# programs do almost no work at run time, so the time is the front end's.
+# 以 bench/gen.c 產生指定大小 (預設 10000 100000 1000000 行) 的原始碼, 用 `c4 --stats`
+# 編譯每個檔案 `reps` 次 (預設 3 次), 並回報最佳實際時間、每秒詞彙數和行數、符號數量
+# 以及每次查詢的平均雜湊探測次數。產生的程式執行時幾乎不做事, 所以時間都花在前端。
+#
+# The c4 binary is $C4 (default ./c4), built from c4.c with $CC (default
+# cc) when missing. // c4 執行檔為 $C4 (預設 ./c4), 不存在時以 $CC (預設 cc) 從 c4.c 編譯
+
+cd "$(dirname "$0")/.." || exit 1
+
+reps=3
+if [ "$1" = "-n" ]; then reps=$2; shift 2; fi
+sizes=("$@")
+if [ ${#sizes[@]} -eq 0 ]; then sizes=(10000 100000 1000000); fi
+
+C4=${C4:-./c4}
+if [ ! -x "$C4" ]; then
+  ${CC:-cc} -O2 -w -o "$C4" c4.c || exit 1
+fi
+
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+${CC:-cc} -O2 -w -o "$dir/gen" bench/gen.c || exit 1
+
+TIMEFORMAT=%R
+status=0
+
+printf "%-8s %9s %10s %12s %12s %9s %7s\n" lines "wall ms" tokens "Ktok/s" "Klines/s" symbols probes
+for n in "${sizes[@]}"; do
+  "$dir/gen" "$n" > "$dir/src.c" || exit 1
+  best=
+  i=0
+  while [ $i -lt "$reps" ]; do
+    { time "$C4" --stats --text-size 1g --data-size 64m --sym-size 64m "$dir/src.c" > "$dir/out"; } 2> "$dir/t"
+    ms=$(awk '{ printf "%d", $1 * 1000 }' "$dir/t")
+    if [ -z "$best" ] || [ "$ms" -lt "$best" ]; then best=$ms; fi
+    i=$((i + 1))
+  done
+
+  # tokens: T, lines: L, ... / symbols: S, lookups: K, probes: P (R per lookup)
+  stats=$(awk '
+    /^tokens: / { t = $2; l = $4; sub(",", "", t); sub(",", "", l) }
+    /^symbols: / { s = $2; sub(",", "", s); r = $7; sub("\\(", "", r) }
+    END { if (t != "") print t, l, s, r }' "$dir/out")
+  if [ -z "$stats" ] || ! tail -n 1 "$dir/out" | grep -q '^exit(0) cycle = '; then
+    printf "%-8s FAILED: %s\n" "$n" "$(head -n 1 "$dir/out")"
+    status=1
+    continue
+  fi
+  read -r tokens lines syms probes <<< "$stats"
+  awk -v n="$n" -v ms="$best" -v t="$tokens" -v l="$lines" -v s="$syms" -v p="$probes" \
+    'BEGIN { printf "%-8s %9d %10d %12.0f %12.0f %9d %7s\n", n, ms, t, ms ? t / ms : 0, ms ? l / ms : 0, s, p }'
+done
+exit $status
@@ -0,0 +1,65 @@
+// Front end benchmark source generator. // 前端效能測試原始碼產生器
+//
+// usage: gen [lines]
+//
+// Writes a c4 program of about `lines` lines (default 10000) to standard // 將大約 `lines` 行 (預設 10000) 的 c4 程式寫到標準輸出
+// output. It repeats a chunk of 100 globals, an enum and a long function // 程式重複以下區塊: 100 個全域變數, 一個列舉, 以及一個長函數
+// whose locals hide some of the globals and whose statements hold deeply // 其區域變數遮蔽部分全域變數, 其語句含有深度巢狀的運算式
+// nested expressions. Only `main` runs, so compiling dominates. // 只有 `main` 會執行, 所以編譯佔大部分時間
+// Both c4 and a host compiler can build it. // c4 和主機編譯器都可以編譯它
+
+#include <stdio.h>
+#define int long long
+
+// Write an expression nested `d` levels deep to the left and to the right. // 寫出向左和向右各巢狀 `d` 層的運算式
+void nest(int c, int d)
+{
+  int i;
+
+  i = 0; while (i < d) { printf("("); i = i + 1; }
+  printf("x");
+  i = 0; while (i < d) { printf(" + g%d_%d)", c, i % 100); i = i + 1; }
+  printf(" * ");
+  i = 0; while (i < d) { printf("(E%d_%d - ", c, i % 20); i = i + 1; }
+  printf("y");
+  i = 0; while (i < d) { printf(")"); i = i + 1; }
+}
+
+int main(int argc, char **argv)
+{
+  char *s;
+  int want, n, c, i;
+
+  want = 10000;
+  if (argc > 1) { s = argv[1]; want = 0; while (*s >= '0' && *s <= '9') want = want * 10 + *s++ - '0'; }
+
+  n = 0; c = 0;
+  while (n < want) {
+    // Globals. // 全域變數
+    i = 0; while (i < 100) { printf("int g%d_%d;\n", c, i); i = i + 1; }
+
+    // An enum. // 列舉
+    printf("enum { E%d_0 = %d", c, c);
+    i = 1; while (i < 20) { printf(", E%d_%d", c, i); i = i + 1; }
+    printf(" };\n");
+
+    // A long function; its locals hide two of the globals. // 長函數; 其區域變數遮蔽其中兩個全域變數
+    printf("int f%d(int a, int b)\n{\n  int x, y, g%d_0, g%d_1;\n  char *p;\n", c, c, c);
+    printf("  x = a; y = b; g%d_0 = E%d_3; g%d_1 = 0; p = \"chunk %d\";\n", c, c, c, c);
+    i = 0;
+    while (i < 50) {
+      printf("  x = ((((x + g%d_%d) * 3) ^ (y - E%d_%d)) & 65535) + (a < b ? g%d_0 : y);\n", c, i + 2, c, i % 20, c);
+      printf("  if (x > y && p[0] == 'c') { y = y + x %% 7; } else { g%d_%d = g%d_1 + 1; }\n", c, i + 2, c);
+      printf("  while (b > 0 && x > -100) { x = x - 1; b = b - 1; }\n");
+      printf("  y = "); nest(c, 16); printf(";\n");
+      i = i + 1;
+    }
+    printf("  return x + y;\n}\n");
+
+    n = n + 100 + 1 + 6 + 50 * 4;
+    c = c + 1;
+  }
+
+  printf("int main()\n{\n  return f0(1, 2) & 0;\n}\n");
+  return 0;
+}
@@ -0,0 +1,51 @@
+// String hashing: builds strings and hashes them byte by byte. // 字串雜湊: 建立字串並逐位元組計算雜湊值
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Write the decimal digits of `n` after `prefix` into `buf`, NUL terminated. // 將 `prefix` 和 `n` 的十進位數字寫入 `buf`, 以空字元結尾
+// Return the length. // 回傳長度
+int key(char *buf, char *prefix, int n)
+{
+  char *p, *q;
+  char t;
+
+  p = buf;
+  while (*prefix) *p++ = *prefix++;
+  q = p;
+  if (n == 0) *p++ = '0';
+  while (n) { *p++ = '0' + n % 10; n = n / 10; }
+  *p = 0;
+
+  // Reverse the digits. // 反轉數字
+  p = p - 1;
+  while (q < p) { t = *q; *q++ = *p; *p-- = t; }
+  return q - buf;
+}
+
+// FNV-1a style hash, kept to 32 bits. // FNV-1a 風格的雜湊, 保持在 32 位元
+int hash(char *s)
+{
+  int h;
+
+  h = 2166136261;
+  while (*s) { h = ((h ^ *s++) * 16777619) & 4294967295; }
+  return h;
+}
+
+int main()
+{
+  char *buf;
+  int i, x;
+
+  buf = malloc(64);
+  x = 0; i = 0;
+  while (i < 300000) {
+    key(buf, "identifier_", i);
+    x = x ^ hash(buf);
+    i = i + 1;
+  }
+  printf("%d\n", x);
+  free(buf);
+  return 0;
+}
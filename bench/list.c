@@ -0,0 +1,41 @@
+// Pointer chasing: walks a linked list laid out in shuffled order. // 指標追逐: 走訪以打亂順序配置的鏈結串列
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// A node is two words: `[0]` next node, `[1]` value. // 節點為兩個字組: `[0]` 下一個節點, `[1]` 值
+int main()
+{
+  int *nodes, **order, *p, n, i, j, r, s, seed;
+
+  n = 100000;
+  nodes = malloc(n * 2 * sizeof(int));
+  order = malloc(n * sizeof(int *));
+
+  // Shuffle the nodes with a linear congruential generator. // 用線性同餘產生器打亂節點
+  i = 0;
+  while (i < n) { order[i] = nodes + i * 2; i = i + 1; }
+  seed = 12345; i = n - 1;
+  while (i > 0) {
+    seed = (seed * 1103515245 + 12345) & 2147483647;
+    j = seed % (i + 1);
+    p = order[i]; order[i] = order[j]; order[j] = p;
+    i = i - 1;
+  }
+
+  // Link them in shuffled order. // 依打亂的順序串接
+  i = 0;
+  while (i < n - 1) { *order[i] = (int)order[i + 1]; order[i][1] = i; i = i + 1; }
+  *order[n - 1] = 0; order[n - 1][1] = n - 1;
+
+  // Walk the list several times. // 走訪串列數次
+  s = 0; r = 0;
+  while (r < 20) {
+    p = order[0];
+    while (p) { s = s + p[1]; p = (int *)*p; }
+    r = r + 1;
+  }
+  printf("%d\n", s);
+  free(order); free(nodes);
+  return 0;
+}
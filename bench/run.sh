@@ -0,0 +1,69 @@
+#!/usr/bin/env bash
+# Benchmark runner for c4. // c4 的效能測試執行器
+#
+# usage: bench/run.sh [-n reps] [c4 options ...]
+#
+# Runs every benchmark `reps` times (default 3) with the given c4 options
+# (e.g. -j or -O), checks its output, and reports the best wall time, the
+# VM cycle count printed by `exit(...)` and cycles per second. `-j` runs
+# print no cycle count, so only the wall time is reported for them.
+# 以指定的 c4 選項 (例: -j 或 -O) 執行每個測試 `reps` 次 (預設 3 次), 檢查輸出,
+# 並回報最佳的實際時間、`exit(...)` 印出的虛擬機週期數以及每秒週期數。
+#
+# The c4 binary is $C4 (default ./c4), built from c4.c with $CC (default
+# cc) when missing. // c4 執行檔為 $C4 (預設 ./c4), 不存在時以 $CC (預設 cc) 從 c4.c 編譯
+
+cd "$(dirname "$0")/.." || exit 1
+
+reps=3
+if [ "$1" = "-n" ]; then reps=$2; shift 2; fi
+
+C4=${C4:-./c4}
+if [ ! -x "$C4" ]; then
+  ${CC:-cc} -O2 -w -o "$C4" c4.c || exit 1
+fi
+
+# name | expected first line of output | c4 arguments after the options
+benches=(
+  "fib|832040|bench/fib.c"
+  "sieve|148933|bench/sieve.c"
+  "hash|-1592624228|bench/hash.c"
+  "list|1214752192|bench/list.c"
+  "selfhost|hello, world|c4.c hello.c"
+  "selfhost2|hello, world|c4.c c4.c hello.c"
+)
+
+TIMEFORMAT=%R
+out=$(mktemp) || exit 1
+trap 'rm -f "$out" "$out.t"' EXIT
+status=0
+
+printf "%-10s %10s %14s %12s\n" bench "wall ms" cycles "Mcycles/s"
+for b in "${benches[@]}"; do
+  IFS='|' read -r name want args <<< "$b"
+  best=
+  i=0
+  while [ $i -lt "$reps" ]; do
+    # shellcheck disable=SC2086
+    { time "$C4" "$@" $args > "$out"; } 2> "$out.t"
+    ms=$(awk '{ printf "%d", $1 * 1000 }' "$out.t")
+    if [ -z "$best" ] || [ "$ms" -lt "$best" ]; then best=$ms; fi
+    i=$((i + 1))
+  done
+
+  if [ "$(head -n 1 "$out")" != "$want" ]; then
+    printf "%-10s FAILED: expected '%s', got '%s'\n" "$name" "$want" "$(head -n 1 "$out")"
+    status=1
+    continue
+  fi
+
+  # The outermost c4 prints the last `exit(...)` line. // 最外層的 c4 印出最後一行 `exit(...)`
+  cycles=$(tail -n 1 "$out" | sed -n 's/^exit(.*) cycle = \([0-9]*\)$/\1/p')
+  if [ -n "$cycles" ]; then
+    rate=$(awk -v c="$cycles" -v ms="$best" 'BEGIN { printf "%.1f", ms ? c / ms / 1000 : 0 }')
+  else
+    cycles=-; rate=-
+  fi
+  printf "%-10s %10s %14s %12s\n" "$name" "$best" "$cycles" "$rate"
+done
+exit $status
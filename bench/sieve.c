@@ -0,0 +1,36 @@
+// Sieve of Eratosthenes: byte loads and stores in tight loops. // 埃拉托斯特尼篩法: 緊密迴圈中的位元組載入與儲存
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory.h>
+
+int main()
+{
+  char *s;
+  int n, i, j, c, r;
+
+  n = 2000000;
+  s = malloc(n + 1);
+
+  // Sieve several times to get a steady running time. // 篩好幾次以取得穩定的執行時間
+  r = 0;
+  while (r < 5) {
+    memset(s, 1, n + 1);
+    s[0] = 0; s[1] = 0;
+    i = 2;
+    while (i * i <= n) {
+      if (s[i]) {
+        j = i * i;
+        while (j <= n) { s[j] = 0; j = j + i; }
+      }
+      i = i + 1;
+    }
+    r = r + 1;
+  }
+
+  c = 0; i = 0;
+  while (i <= n) { if (s[i]) c = c + 1; i = i + 1; }
+  printf("%d\n", c);
+  free(s);
+  return 0;
+}
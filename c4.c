@@ -1,7 +1,7 @@
 // c4.c - C in four functions // 用 4 個函數寫出 C 語言
 
 // char, int, and pointer types // 只支援字元、整數和指標型態
-// if, while, return, and expression statements // 語法上則支援 if, while, return 和表達式語句
+// if, while, for, switch, break, return, and expression statements // 語法上則支援 if, while, for, switch, break, return 和表達式語句
 // just enough features to allow self-compilation and a bit more // 剛好有足夠的功能來進行自編譯和其他事
 
 // Written by Robert Swierczek
@@ -11,33 +11,148 @@
 #include <memory.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__GNUC__)
+#include <pthread.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+typedef int cint; // the host's `int`, for calls that take an `int *` // 主機的 `int`, 供參數為 `int *` 的呼叫使用
+#endif
+#if defined(__GNUC__) && defined(__SSE2__)
+#include <immintrin.h>
+#endif
 #define int long long
 
+#if defined(__GNUC__)
+// A failing `--batch` job must not take the other jobs down with it: while // 失敗的 `--batch` 工作不能連帶結束其他工作:
+// a job runs, `exit` jumps back to its worker with the exit code. // 工作執行時, `exit` 帶著離開代碼跳回其工作執行緒
+__thread jmp_buf *jfail; __thread int jcode;
+#define exit(n) (jfail ? (jcode = (n), longjmp(*jfail, 1)) : exit(n))
+#endif
+
+// Options and opcode names, shared by every program a process runs. // 選項和操作碼名稱, 由行程執行的所有程式共用
+char *opname, // opcode names, 5 characters each (操作碼名稱, 每個 5 個字元)
+     *ccls,   // class of each character, indexed by `char` from -128 (每個字元的類別, 以 -128 起的 `char` 為索引)
+     *out,    // bytecode image to write (要寫出的位元組碼映像)
+     *sock;   // `--serve` socket path (`--serve` 的 socket 路徑)
+
+int src,      // print source and assembly flag (印出原始碼)
+    debug,    // print executed instructions (印出執行指令 -- 除錯模式)
+    jit,      // run as native code flag (編譯成原生機器碼執行)
+    prof,     // profile execution flag (執行剖析)
+    lines,    // count executions per source line flag (計算每個原始碼行的執行次數)
+    opt,      // peephole optimize flag (窺孔最佳化)
+    stats,    // print compile statistics flag (印出編譯統計)
+    regvm,    // run on the register VM flag (在暫存器虛擬機上執行)
+    diff,     // run on both VMs and compare flag (在兩種虛擬機上執行並比較)
+    tsz, dsz, ssz, ysz, // text, data, stack and symbol area sizes (程式碼、資料、堆疊和符號表區域的大小)
+    osz,      // guest output buffer size (客體程式輸出緩衝區的大小)
+    heap,     // pooled guest heap flag (客體程式記憶體池)
+    hsz,      // pooled guest heap size (客體程式記憶體池的大小)
+    nthread;  // `--batch` worker threads (`--batch` 的工作執行緒數量)
+
+// Compiler and VM context: everything below that holds state for one // 編譯器和虛擬機的上下文: 以下所有保存單一程式狀態的全域變數
+// program. A host build gives each thread its own copy, so the `--batch` // 主機編譯版本讓每個執行緒擁有自己的一份,
+// workers compile and run their jobs side by side; `reset` clears it for // 所以 `--batch` 的工作執行緒可以同時編譯和執行各自的工作;
+// the next job. The VM registers are locals of `run`. // `reset` 為下一個工作清除它. 虛擬機暫存器是 `run` 的區域變數
+#if defined(__GNUC__)
+__thread
+#endif
 char *p, *lp, // current position in source code (p: 目前原始碼指標, lp: 上一行原始碼指標)
-     *data;   // data/bss pointer (資料段機器碼指標)
-
+     *sbuf,   // mapped source code file (映射的原始碼檔案)
+     *data,   // data/bss pointer (資料段機器碼指標)
+     *dbase,  // data segment (資料段起始位址)
+     *dlim;   // data area limit (資料區上限)
+
+#if defined(__GNUC__)
+__thread
+#endif
 int *e, *le,  // current position in emitted code (e: 目前機器碼指標, le: 上一行機器碼指標)
+    *text,    // text segment (機器碼段起始位址)
+    *tlim,    // text area limit (程式碼區上限)
     *id,      // currently parsed identifier (id: 目前的 id)
-    *sym,     // symbol table (simple list of identifiers) (符號表)
+    *li,      // last fused load or compare emitted, for later fusion (最近一個可再融合的載入或比較指令)
+    *tcall,   // end of the last function call emitted, for tail calls (最近輸出的函數呼叫的結尾, 供尾呼叫使用)
+    laddr,    // the function being compiled takes a local's address, so makes no tail calls (正在編譯的函數取用了區域變數的位址, 所以不做尾呼叫)
+    *fent,    // `ENT` of the function being compiled (正在編譯的函數的 `ENT`)
+    *brks,    // operand of the last `break` jump, which links to the previous one's, or 0 (最近一個 `break` 跳轉的運算元, 鏈結到前一個的, 或 0)
+    nbrk,     // loops and switches around the statement being compiled (包圍正在編譯的語句的迴圈和 switch 數量)
+    *swb,     // first (value, address) case pair of the innermost switch, or 0 (最內層 switch 的第一個 (數值, 位址) case 對, 或 0)
+    *swd,     // default label of the innermost switch, or 0 (最內層 switch 的 default 標籤, 或 0)
+    *swp,     // end of the case pairs (case 對的結尾)
+    *swlim,   // case pair area limit (case 對區域上限)
+    *sym,     // symbol table (dense array of identifiers) (符號表)
+    *symend,  // first unused symbol table entry (第一個未使用的符號表條目)
+    *symlim,  // symbol table limit (符號表上限)
+    **symidx, // open addressing hash index into `sym` (`sym` 的開放定址雜湊索引)
+    symmask,  // hash index size - 1, size is a power of 2 (雜湊索引大小 - 1, 大小為 2 的次方)
+    *shadow,  // saved fields of symbols hidden by locals (被區域變數遮蔽的符號的備份欄位)
+    *shp,     // top of `shadow` (`shadow` 的頂端)
+    *slim,    // lowest stack address a function may enter with (函數進入時堆疊位址的下限)
+    *lnt,     // pc to line table: (text offset where a line's code starts, line) pairs (pc 對行號表: (某行程式碼起始的程式碼段位移, 行號) 對)
+    *lnp,     // end of `lnt` (`lnt` 的結尾)
+    *lmark,   // last code word covered by `lnt` (`lnt` 涵蓋的最後一個程式碼字組)
+    nlook,    // symbol lookups, for `--stats` (符號查詢次數)
+    nprobe,   // hash index slots probed, for `--stats` (雜湊索引探查次數)
+    ntok,     // tokens read, for `--stats` (讀取的 token 數量)
     tk,       // current token (目前 token)
     ival,     // current token value (目前的 token 值)
     ty,       // current expression type (目前的運算式型態)
     loc,      // local variable offset (區域變數的位移)
-    line,     // current line number (目前行號)
-    src,      // print source and assembly flag (印出原始碼)
-    debug;    // print executed instructions (印出執行指令 -- 除錯模式)
+    *alist,   // (address, size) of each mapping to release after a `--batch` job (每個 `--batch` 工作結束後要釋放的映射的 (位址, 大小))
+    *alp,     // end of `alist`, or 0 to not keep the list (`alist` 的結尾, 為 0 時不保留清單)
+    *alend,   // limit of `alist` (`alist` 的上限)
+    line;     // current line number (目前行號)
 
 // tokens and classes (operators last and in precedence order) (按優先權順序排列)
+// `Assign` is `=` with `ival` 0, or a compound assignment such as `+=` // `Assign` 是 `ival` 為 0 的 `=`,
+// with `ival` the operator's token, `Add`. // 或是 `ival` 為運算符 token (如 `Add`) 的複合賦值 (如 `+=`)
 enum { // token : 0-127 直接用該字母表達， 128 以後用代號。
   Num = 128, Fun, Sys, Glo, Loc, Id,
-  Char, Else, Enum, If, Int, Return, Sizeof, While,
+  Break, Case, Char, Default, Else, Enum, For, If, Int, Return, Sizeof, Switch, While,
   Assign, Cond, Lor, Lan, Or, Xor, And, Eq, Ne, Lt, Gt, Le, Ge, Shl, Shr, Add, Sub, Mul, Div, Mod, Inc, Dec, Brak
 };
 
 // opcodes (操作碼)
-enum { LEA ,IMM ,JMP ,JSR ,BZ  ,BNZ ,ENT ,ADJ ,LEV ,LI  ,LC  ,SI  ,SC  ,PSH ,
+// `LLI` to `BGE` are superinstructions fused by `expr` and `stmt`: // `LLI` 到 `BGE` 是由 `expr` 和 `stmt` 融合而成的超級指令
+// `LLI n` = `LEA n; LI`, `SLI n` = store to local, `LGI x` = `IMM x; LI`, // `LLI n` = `LEA n; LI`, `SLI n` = 儲存到區域變數, `LGI x` = `IMM x; LI`
+// `SGI x` = store to global, `ADDI k` = `PSH; IMM k; ADD`, // `SGI x` = 儲存到全域變數, `ADDI k` = `PSH; IMM k; ADD`
+// `BEQ` .. `BGE` = `EQ` .. `GE` followed by `BNZ`. // `BEQ` .. `BGE` = `EQ` .. `GE` 之後接 `BNZ`
+// `TJSR f` is a tail call: it moves the arguments of `JSR f; ADJ n` over // `TJSR f` 是尾呼叫: 將 `JSR f; ADJ n` 的參數移到
+// the current function's and jumps to `f` in place of a `LEV`. // 目前函數的參數上, 並代替 `LEV` 跳到 `f`
+// `JTAB n` is followed by `n + 1` `JMP`s and jumps to the target of the // `JTAB n` 之後接著 `n + 1` 個 `JMP`, 它跳到第 `a` 個的目標,
+// `a`th, or of the last one if `a` is not in 0 .. `n - 1`. // 若 `a` 不在 0 .. `n - 1` 之間則跳到最後一個的目標
+// Opcodes up to `BGE` have an operand. // `BGE` (含) 之前的操作碼都有運算元
+enum { LEA ,IMM ,JMP ,JSR ,BZ  ,BNZ ,ENT ,ADJ ,TJSR,JTAB,
+       LLI ,SLI ,LGI ,SGI ,ADDI,BEQ ,BNE ,BLT ,BGT ,BLE ,BGE ,
+       LEV ,LI  ,LC  ,SI  ,SC  ,PSH ,
        OR  ,XOR ,AND ,EQ  ,NE  ,LT  ,GT  ,LE  ,GE  ,SHL ,SHR ,ADD ,SUB ,MUL ,DIV ,MOD ,
-       OPEN,READ,CLOS,PRTF,MALC,FREE,MSET,MCMP,EXIT };
+       OPEN,READ,CLOS,PRTF,MALC,FREE,MSET,MCMP,MCPY,MCHR,SLEN,SCMP,SCHR,
+       MMAP,LSEK,WRIT,MUNM,FSTA,MRST,EXIT };
+
+// open, mmap and lseek arguments (open, mmap 和 lseek 的參數)
+#if defined(MAP_ANONYMOUS)
+enum { PGSZ = 4096, PROT_RW = PROT_READ | PROT_WRITE, MAP_ARENA = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE };
+#else
+// c4 sees the Linux values. // c4 看到的是 Linux 的值
+enum { PGSZ = 4096, PROT_RW = 3, MAP_ARENA = 0x4022, MAP_FIXED = 0x10,
+       PROT_READ = 1, MAP_PRIVATE = 2, SEEK_END = 2, O_WRONLY = 1, O_CREAT = 0x40, O_TRUNC = 0x200 };
+#endif
+
+// bytecode image header written by `-o` (由 `-o` 寫出的位元組碼映像標頭)
+// `Magic`: `C4B`. // `Magic`: `C4B`
+// `Ntext`: Text segment size in words, `Ndata`: data segment size in bytes. // `Ntext`: 程式碼段的字組數, `Ndata`: 資料段的位元組數
+// `Entry`: `main`'s word offset in the text segment. // `Entry`: `main` 在程式碼段中的字組位移
+// `Nrel`: Number of relocations. // `Nrel`: 重定位的數量
+// `Hdrsz`: Header size in words. // `Hdrsz`: 標頭的字組數
+enum { Magic, Ntext, Ndata, Entry, Nrel, Hdrsz };
+// `C4B` is the bytes "\0c4b6", and no source file starts with a `\0`. // `C4B` 是位元組 "\0c4b6", 而原始碼檔案不會以 `\0` 開頭
+// The last byte is the opcode numbering's version. // 最後一個位元組是操作碼編號的版本
+enum { C4B = 0x3662346300 };
 
 // types (支援型態，只有 int, char, pointer)
 enum { CHAR, INT, PTR };
@@ -55,16 +170,155 @@ enum { CHAR, INT, PTR };
 // - Loc: Local variable name. // 區域變數名稱
 // `Type`: Associated value type. e.g. `CHAR`, `INT`. // 關聯值型態 (例: 字元、整數)
 // `Val`: Associated value. // 關聯值
-// `HClass`: Backup field for `Class` field. // `Class` 字段的備用字段
-// `HType`: Backup field for `Type` field. // `Type` 字段的備用字段
-// `HVal`: Backup field for `Val` field. // `Val` 字段的備用字段
-// `Idsz`: Symbol table entry size. // `Idsz` 字段的備用字段
-enum { Tk, Hash, Name, Class, Type, Val, HClass, HType, HVal, Idsz };
+// `Idsz`: Symbol table entry size. // 符號表條目的大小
+// The fields of a symbol hidden by a local are saved on `shadow`. // 被區域變數遮蔽的符號欄位備份在 `shadow` 上
+enum { Tk, Hash, Name, Class, Type, Val, Idsz };
+
+// character classes in `ccls` (`ccls` 中的字元類別)
+// `Cnone`: Any other character, `Cspace`: blank other than newline, // 其他字元, 換行以外的空白,
+// `Cident`: letter or `_`, `Cdigit`: digit. // 字母或 `_`, 數字
+enum { Cnone, Cspace, Cident, Cdigit };
+
+#if defined(__GNUC__) && defined(__SSE2__)
+// Bulk scans for `next`, a vector of 16 bytes (SSE2) or 32 bytes (AVX2, if // `next` 使用的大量掃描, 每次處理一個 16 位元組 (SSE2)
+// the compiler targets it) at a time. The loads are aligned, so they never // 或 32 位元組 (AVX2, 若編譯器以其為目標) 的向量
+// cross into a page past the `\0` that ends the source. // 載入是對齊的, 所以不會跨入原始碼結尾 `\0` 之後的分頁
+// c4 itself skips this block (see `next`). // c4 本身會跳過這個區塊 (見 `next`)
+#if defined(__AVX2__)
+typedef __m256i vec;
+enum { VW = 32 };
+#define vload(b)    _mm256_load_si256((vec *)(b))
+#define vset(c)     _mm256_set1_epi8(c)
+#define veq(v, c)   _mm256_cmpeq_epi8(v, vset(c))
+#define vgt(v, c)   _mm256_cmpgt_epi8(v, vset(c))
+#define vlt(v, c)   _mm256_cmpgt_epi8(vset(c), v)
+#define vor(x, y)   _mm256_or_si256(x, y)
+#define vand(x, y)  _mm256_and_si256(x, y)
+#define vmask(v)    (unsigned)_mm256_movemask_epi8(v)
+#else
+typedef __m128i vec;
+enum { VW = 16 };
+#define vload(b)    _mm_load_si128((vec *)(b))
+#define vset(c)     _mm_set1_epi8(c)
+#define veq(v, c)   _mm_cmpeq_epi8(v, vset(c))
+#define vgt(v, c)   _mm_cmpgt_epi8(v, vset(c))
+#define vlt(v, c)   _mm_cmpgt_epi8(vset(c), v)
+#define vor(x, y)   _mm_or_si128(x, y)
+#define vand(x, y)  _mm_and_si128(x, y)
+#define vmask(v)    (unsigned)_mm_movemask_epi8(v)
+#endif
+
+// Scan kinds for `vfind`. // `vfind` 的掃描種類
+enum { Veol, Vspace, Vident, Vstr };
+
+// Return a bit mask of the bytes in the aligned vector at `b` where a scan // 回傳位於 `b` 的對齊向量中, 種類為 `k` 的掃描
+// of kind `k` stops. `q` is the quote that ends a string. // 會停止的位元組的位元遮罩. `q` 是結束字串的引號
+unsigned vstop(char *b, int k, int q)
+{
+  vec v, l;
+
+  v = vload(b);
+  // Newline or end. // 換行或結尾
+  if (k == Veol) return vmask(vor(veq(v, '\n'), veq(v, 0)));
+  // Quote, backslash or end. // 引號、反斜線或結尾
+  if (k == Vstr) return vmask(vor(vor(veq(v, q), veq(v, '\\')), veq(v, 0)));
+  // Anything but a blank other than newline. // 換行以外的空白之外的任何字元
+  if (k == Vspace)
+    return ~vmask(vor(vor(veq(v, ' '), veq(v, '\t')), vand(vgt(v, '\n'), vlt(v, '\r' + 1)))) &
+    (unsigned)((1LL << VW) - 1);
+  // Anything but a letter, digit or `_`. Bytes from 128 are negative, so // 字母、數字或 `_` 之外的任何字元
+  // they fail the signed range checks. // 128 以上的位元組是負數, 所以不會通過有號的範圍檢查
+  l = vor(v, vset(0x20));
+  return ~vmask(vor(vor(vand(vgt(l, 'a' - 1), vlt(l, 'z' + 1)), vand(vgt(v, '0' - 1), vlt(v, '9' + 1))), veq(v, '_'))) &
+    (unsigned)((1LL << VW) - 1);
+}
+
+// Return the first byte at or after `p` where a scan of kind `k` stops. // 回傳 `p` 或其後第一個讓種類為 `k` 的掃描停止的位元組
+char *vfind(char *p, int k, int q)
+{
+  char *b;
+  unsigned m;
+
+  b = (char *)((int)p & -VW);
+  m = vstop(b, k, q) & (~0u << (p - b));
+  while (!m) { b = b + VW; m = vstop(b, k, q); }
+  return b + __builtin_ctz(m);
+}
+
+// Most runs are a few bytes long, so the scans below look at the first // 大部分的連續字元只有幾個位元組,
+// `Vrun` bytes one at a time before going to `vfind`. // 所以以下的掃描先逐一檢查前 `Vrun` 個位元組, 再使用 `vfind`
+enum { Vrun = 8 };
+
+// Skip to the newline or `\0` at or after `p`. // 跳到 `p` 或其後的換行或 `\0`
+char *skipeol(char *p)
+{
+  char *t;
+
+  t = p + Vrun;
+  while (p < t) { if (*p == 0 || *p == '\n') return p; ++p; }
+  return vfind(p, Veol, 0);
+}
+
+// Skip the blanks other than newline at `p`. // 跳過 `p` 處換行以外的空白
+char *skipsp(char *p)
+{
+  char *t;
+
+  t = p + Vrun;
+  while (p < t) { if (ccls[*p] != Cspace) return p; ++p; }
+  return vfind(p, Vspace, 0);
+}
+
+// Skip the letters, digits and `_` at `p`. // 跳過 `p` 處的字母、數字和 `_`
+char *skipid(char *p)
+{
+  char *t;
+
+  t = p + Vrun;
+  while (p < t) { if (ccls[*p] < Cident) return p; ++p; }
+  return vfind(p, Vident, 0);
+}
+
+// Copy the string characters at `p` up to the next quote `q`, backslash or // 將 `p` 處到下一個引號 `q`、反斜線或 `\0` 之前的字串字元
+// `\0` to the data area. Return where the copy stopped. // 複製到資料區. 回傳複製停止的位置
+char *cpstr(char *p, int q)
+{
+  char *t;
+
+  t = p + Vrun;
+  while (p < t && *p != 0 && *p != q && *p != '\\') *data++ = *p++;
+  t = (p < t) ? p : vfind(p, Vstr, q);
+  if (data + (t - p) > dlim) { printf("%d: data area full\n", line); exit(-1); }
+  memcpy(data, p, t - p); data = data + (t - p);
+  return t;
+}
+#else
+// Scalar versions of the bulk scans, for c4 and other hosts. // 大量掃描的純量版本, 供 c4 和其他主機使用
+char *skipeol(char *p) { while (*p != 0 && *p != '\n') ++p; return p; }
+char *skipsp(char *p) { while (ccls[*p] == Cspace) ++p; return p; }
+char *skipid(char *p) { while (ccls[*p] >= Cident) ++p; return p; }
+char *cpstr(char *p, int q)
+{
+  while (*p != 0 && *p != q && *p != '\\') {
+    if (data > dlim) { printf("%d: data area full\n", line); exit(-1); }
+    *data++ = *p++;
+  }
+  return p;
+}
+#endif
 
 // Read token. // 讀取 token
 void next() // 詞彙解析 lexer
 {
   char *pp;
+  int n, h, c;
+
+  // Stop with an error before an area overflows. A token adds at most one // 在區域溢位之前以錯誤停止
+  // symbol and far less code or data than the margins `main` leaves. // 一個 token 最多新增一個符號, 而程式碼或資料遠少於 `main` 保留的餘裕
+  if (e > tlim) { printf("%d: text area full\n", line); exit(-1); }
+  if (data > dlim) { printf("%d: data area full\n", line); exit(-1); }
+  if (symend > symlim) { printf("%d: symbol table full\n", line); exit(-1); }
+  ++ntok;
 
   // Get current character. // 取得當前字元
   // While current character is not `\0`. // 當當前字元不為空字元
@@ -73,8 +327,17 @@ void next() // 詞彙解析 lexer
     // Point to next character. // 指向下一個字元
     ++p;
 
+    // Look up the character's class once; blanks, identifiers and numbers // 查一次字元的類別; 空白、識別字和數字
+    // are told apart by it instead of by chains of comparisons. // 以類別區分, 而不是以一連串的比較
+    c = ccls[tk];
+
+    // Skip a run of blanks. // 跳過一連串的空白
+    if (c == Cspace) p = skipsp(p);
     // If current character is newline. // 如果新字元是換行字元
-    if (tk == '\n') {
+    else if (tk == '\n') {
+      // Record where the code emitted for this line starts. // 記錄這一行產生的程式碼從哪裡開始
+      if (e > lmark) { *lnp++ = lmark + 1 - text; *lnp++ = line; lmark = e; }
+
       // If switch for printing source code line and corresponding instructions
       // is on. // 如果有用到 c4 的 -s 參數
       if (src) {
@@ -87,13 +350,11 @@ void next() // 詞彙解析 lexer
         // While have instruction to print. // 當有指令要印
         while (le < e) {
           // Print opcode. // 印出操作碼
-          printf("%8.4s", &"LEA ,IMM ,JMP ,JSR ,BZ  ,BNZ ,ENT ,ADJ ,LEV ,LI  ,LC  ,SI  ,SC  ,PSH ,"
-                           "OR  ,XOR ,AND ,EQ  ,NE  ,LT  ,GT  ,LE  ,GE  ,SHL ,SHR ,ADD ,SUB ,MUL ,DIV ,MOD ,"
-                           "OPEN,READ,CLOS,PRTF,MALC,FREE,MSET,MCMP,EXIT,"[*++le * 5]);
+          printf("%8.4s", &opname[*++le * 5]);
 
-          // If the opcode <= ADJ, it has operand. // 當操作碼為 LEA、IMM、JMP、JSR、BZ、BNZ、ENT、ADJ 其中之一, 則他有運算元
+          // If the opcode <= BGE, it has operand. // 當操作碼為 LEA 到 BGE 其中之一, 則他有運算元
           // Print operand. // 印出運算元
-          if (*le <= ADJ) printf(" %d\n", *++le); else printf("\n");
+          if (*le <= BGE) printf(" %d\n", *++le); else printf("\n");
         }
       }
 
@@ -103,41 +364,92 @@ void next() // 詞彙解析 lexer
     // If current character is `#`, it is preprocessing directive. // 如果當前字元為井字號, 則他是預處理指令
     // Preprocessing directive is ignored. // 預處理指令是被忽略的
     else if (tk == '#') {
-      // While current character is not `\0` and current character is not
-      // newline. // 當當前字元不是空字元也不是換行字元
-      // Skip current character. // 跳過該字元
-      while (*p != 0 && *p != '\n') ++p;
+      // c4 has no preprocessor and defines no macros, so an `#if` whose // c4 沒有預處理器也不定義任何巨集,
+      // condition is only `defined(...)` tests joined by `&&` or `||` is // 所以條件只由 `&&` 或 `||` 連接的 `defined(...)` 測試組成的 `#if` 為假:
+      // false: skip to the matching `#else` or `#endif`. This lets code that // 直接跳到對應的 `#else` 或 `#endif`
+      // only a host compiler understands (e.g. GNU C extensions) sit in an // 讓只有主機編譯器看得懂的程式碼 (例: GNU C 擴充)
+      // `#if defined(__GNUC__)` block, with a portable `#else` branch for c4 // 放在 `#if defined(__GNUC__)` 區塊中,
+      // itself. Other directives are ignored, and the lines they guard are // 並以 `#else` 分支提供 c4 可編譯的版本
+      // compiled. // 其他指令則被忽略, 它們所圍住的行照常編譯
+      // `n` is 1 while the condition read so far is such tests, 2 once all of it is. // 讀到目前的條件都是這種測試時 `n` 為 1, 全部都是時為 2
+      n = 0;
+      if (p[0] == 'i' && p[1] == 'f' && p[2] == ' ') { n = 1; pp = p + 2; }
+      while (n == 1) {
+        while (*pp == ' ') ++pp;
+        if (memcmp(pp, "defined(", 8)) n = 0;
+        else {
+          pp = skipid(pp + 8);
+          if (*pp++ != ')') n = 0;
+          else {
+            while (*pp == ' ') ++pp;
+            if ((*pp == '&' && pp[1] == '&') || (*pp == '|' && pp[1] == '|')) pp = pp + 2;
+            else if (*pp == '\n' || *pp == '/' || *pp == 0) n = 2;
+            else n = 0;
+          }
+        }
+      }
+      if (n) {
+        // `n` is the `#if` nesting depth. // `n` 是 `#if` 的巢狀深度
+        n = 1;
+
+        // While the block is not closed and input is not at end. // 當區塊尚未結束且輸入尚未結束
+        while (n && *p) {
+          // Skip to next line. // 跳到下一行
+          p = skipeol(p);
+
+          // Count the skipped line, printing it if `-s` is on. // 計算被跳過的行, 若有 `-s` 參數則印出該行
+          if (*p) { ++p; if (src) { printf("%d: %.*s", line, p - lp, lp); lp = p; } ++line; }
+
+          // Look at the directive, if any, that starts the new line. // 檢查新一行開頭的預處理指令
+          pp = p; while (*pp == ' ') ++pp;
+          if (*pp == '#') {
+            ++pp;
+            // Nested `#if`, `#ifdef` or `#ifndef`. // 巢狀的 `#if`, `#ifdef` 或 `#ifndef`
+            if (pp[0] == 'i' && pp[1] == 'f') ++n;
+            // `#endif` closes one level. // `#endif` 結束一層
+            else if (pp[0] == 'e' && pp[1] == 'n' && pp[2] == 'd') --n;
+            // `#else` of the outermost block resumes parsing. // 最外層的 `#else` 恢復解析
+            else if (n == 1 && pp[0] == 'e' && pp[1] == 'l' && pp[2] == 's') n = 0;
+          }
+        }
+      }
+
+      // Skip to the newline or `\0`. // 跳到換行或空字元
+      p = skipeol(p);
     }
     // If current character is letter or underscore, it is identifier. // 如果當前字元為字母或下劃線, 則他是一個變數名稱
-    else if ((tk >= 'a' && tk <= 'z') || (tk >= 'A' && tk <= 'Z') || tk == '_') {
+    else if (c == Cident) {
       // Point `pp` to the first character. // 將 `pp` 指向第一個字元
       pp = p - 1;
 
-      // While current character is letter, digit, or underscore. // 當當前字元為字母、數字或下劃線
-      while ((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') || (*p >= '0' && *p <= '9') || *p == '_')
-        // Use current character to compute hash value. // 使用當前字元來計算雜湊值
-        tk = tk * 147 + *p++;
+      // Find the end of the name, then hash its letters, digits and // 找到名稱的結尾, 再用其字母、數字和底線
+      // underscores. // 計算雜湊值
+      h = (int)skipid(p);
+      while (p < (char *)h) tk = tk * 147 + *p++;
 
       // Combine the hash value with string length. // 將雜湊值與字串長度結合在一起
       tk = (tk << 6) + (p - pp);
 
-      // Point `id` to symbol table. // 將 `id` 指向符號表
-      id = sym;
+      // Mix the high hash bits into the slot index. // 將雜湊值的高位元混入槽位索引
+      h = (tk ^ (tk >> 11) ^ (tk >> 23)) & symmask;
+      ++nlook; ++nprobe;
 
-      // While current symbol table entry is in use. // 當當前的符號表條目正在使用中
-      while (id[Tk]) {
+      // While the hash index slot is in use, point `id` to its entry. // 當雜湊索引槽位正在使用中, 將 `id` 指向其條目
+      while ((id = symidx[h])) {
         // 如果 token 的雜湊值和名稱, 跟當前符號表條目的雜湊值和名稱相等
         // If current symbol table entry's hash is equal and name is equal, it
         // means the name has been seen before. // 則表示該變數名稱已經見過
         // Set token type be the entry's token type. // 將 token 類型設定為該變數的 token 類型, 然後直接 return
         if (tk == id[Hash] && !memcmp((char *)id[Name], pp, p - pp)) { tk = id[Tk]; return; }
 
-        // Point to next table entry. // 不然就指向下一個符號表條目
-        id = id + Idsz;
+        // Probe the next slot. // 不然就探查下一個槽位
+        h = (h + 1) & symmask; ++nprobe;
       }
 
       // At this point, existing symbol name is not found. // 到了這裡, 則表示找不到該變數名稱
-      // `id` is pointing to the first unused symbol table entry. // 將 `id` 指向到第一個未使用的符號表條目
+      // Take the first unused symbol table entry and index it in the empty // 取用第一個未使用的符號表條目
+      // slot. // 並將它放入空的槽位
+      id = symidx[h] = symend; symend = symend + Idsz;
 
       // Store the name's string address. // 儲存變數名稱的字串位址
       id[Name] = (int)pp;
@@ -151,7 +463,7 @@ void next() // 詞彙解析 lexer
       return;
     }
     // If current character is digit, it is number constant. // 如果當前字元是數字, 則他是一個常數
-    else if (tk >= '0' && tk <= '9') {
+    else if (c == Cdigit) {
       // If current character is not `0`, it is decimal notation. // 如果當前字元不是 0, 則他是十進位
       // Convert decimal notation to value. // 將十進位轉換成值
       if (ival = tk - '0') { while (*p >= '0' && *p <= '9') ival = ival * 10 + *p++ - '0'; }
@@ -176,14 +488,11 @@ void next() // 詞彙解析 lexer
     else if (tk == '/') {
       // If following character is `/`, it is comments. // 如果下一個字元還是正斜線, 則他是註解
       if (*p == '/') {
-        // Point to next character. // 指向到下一個字元
-        ++p;
-
-        // While current character is not `\0` and current character is not
-        // newline. // 當當前字元不是空字元也不是換行字元
-        // Skip current character. // 跳過當前字元
-        while (*p != 0 && *p != '\n') ++p;
+        // Skip to the newline or `\0`. // 跳到換行或空字元
+        p = skipeol(p + 1);
       }
+      // If following character is `=`, it is `/=`. // 如果下一個字元是等號, 則他是 `/=`
+      else if (*p == '=') { ++p; tk = Assign; ival = Div; return; }
       // If following character is not `/`, it is division operator. // 如果下一個字元不是正斜線, 則他是除法運算符
       else {
         // Set token type. // 設定 token 類型
@@ -201,15 +510,20 @@ void next() // 詞彙解析 lexer
       // While current character is not `\0` and current character is not the
       // quote character. // 當當前字元不是空字元且不是引號
       while (*p != 0 && *p != tk) {
-        // If current character is `\`, it is escape notation or simply `\`
-        // character. // 如果當前字元是反斜線, 則他是跳脫字元或是單純的反斜線
-        if ((ival = *p++) == '\\') {
-          // If following character is `n`, it is newline escape, // 如果下一個字元是 n, 則他是一個跳脫/換行字元
-          if ((ival = *p++) == 'n') ival = '\n';
-        }
+        // Copy a string's run of plain characters at once. It can be longer // 一次複製字串中一連串的一般字元
+        // than the margin, so `cpstr` checks the data area itself. // 它可能比餘裕還長, 所以 `cpstr` 自己檢查資料區
+        if (tk == '"' && *p != '\\') p = cpstr(p, tk);
+        else {
+          // If current character is `\`, it is escape notation or simply `\`
+          // character. // 如果當前字元是反斜線, 則他是跳脫字元或是單純的反斜線
+          if ((ival = *p++) == '\\') {
+            // If following character is `n`, it is newline escape, // 如果下一個字元是 n, 則他是一個跳脫/換行字元
+            if ((ival = *p++) == 'n') ival = '\n';
+          }
 
-        // If it is string constant, copy current character to data buffer. // 如果他是一個字串, 就將當前字元複製到資料段裡
-        if (tk == '"') *data++ = ival;
+          // If it is string constant, copy current character to data buffer. // 如果他是一個字串, 就將當前字元複製到資料段裡
+          if (tk == '"') { if (data > dlim) { printf("%d: data area full\n", line); exit(-1); } *data++ = ival; }
+        }
       }
 
       // Point to next character. // 指向下一個字元
@@ -223,23 +537,78 @@ void next() // 詞彙解析 lexer
 
       return;
     }
-    else if (tk == '=') { if (*p == '=') { ++p; tk = Eq; } else tk = Assign; return; }
-    else if (tk == '+') { if (*p == '+') { ++p; tk = Inc; } else tk = Add; return; }
-    else if (tk == '-') { if (*p == '-') { ++p; tk = Dec; } else tk = Sub; return; }
+    else if (tk == '=') { if (*p == '=') { ++p; tk = Eq; } else { tk = Assign; ival = 0; } return; }
+    // An operator followed by `=` is a compound assignment. // 運算符之後接著 `=` 是複合賦值
+    else if (tk == '+') { if (*p == '+') { ++p; tk = Inc; return; } else tk = Add; }
+    else if (tk == '-') { if (*p == '-') { ++p; tk = Dec; return; } else tk = Sub; }
     else if (tk == '!') { if (*p == '=') { ++p; tk = Ne; } return; }
-    else if (tk == '<') { if (*p == '=') { ++p; tk = Le; } else if (*p == '<') { ++p; tk = Shl; } else tk = Lt; return; }
-    else if (tk == '>') { if (*p == '=') { ++p; tk = Ge; } else if (*p == '>') { ++p; tk = Shr; } else tk = Gt; return; }
-    else if (tk == '|') { if (*p == '|') { ++p; tk = Lor; } else tk = Or; return; }
-    else if (tk == '&') { if (*p == '&') { ++p; tk = Lan; } else tk = And; return; }
-    else if (tk == '^') { tk = Xor; return; }
-    else if (tk == '%') { tk = Mod; return; }
-    else if (tk == '*') { tk = Mul; return; }
+    else if (tk == '<') { if (*p == '=') { ++p; tk = Le; return; } else if (*p == '<') { ++p; tk = Shl; } else { tk = Lt; return; } }
+    else if (tk == '>') { if (*p == '=') { ++p; tk = Ge; return; } else if (*p == '>') { ++p; tk = Shr; } else { tk = Gt; return; } }
+    else if (tk == '|') { if (*p == '|') { ++p; tk = Lor; return; } else tk = Or; }
+    else if (tk == '&') { if (*p == '&') { ++p; tk = Lan; return; } else tk = And; }
+    else if (tk == '^') tk = Xor;
+    else if (tk == '%') tk = Mod;
+    else if (tk == '*') tk = Mul;
+    if (tk >= Or && tk <= Mod) { if (*p == '=') { ++p; ival = tk; tk = Assign; } return; }
     else if (tk == '[') { tk = Brak; return; }
     else if (tk == '?') { tk = Cond; return; }
     else if (tk == '~' || tk == ';' || tk == '{' || tk == '}' || tk == '(' || tk == ')' || tk == ']' || tk == ',' || tk == ':') return;
   }
 }
 
+// Compute `a op b` for binary opcode `op` the way the VM does. // 以虛擬機的方式計算二元操作碼 `op` 的 `a op b`
+int fold(int op, int a, int b)
+{
+  if (op == OR)  return a | b;
+  if (op == XOR) return a ^ b;
+  if (op == AND) return a & b;
+  if (op == EQ)  return a == b;
+  if (op == NE)  return a != b;
+  if (op == LT)  return a < b;
+  if (op == GT)  return a > b;
+  if (op == LE)  return a <= b;
+  if (op == GE)  return a >= b;
+  if (op == SHL) return a << b;
+  if (op == SHR) return a >> b;
+  if (op == ADD) return a + b;
+  if (op == SUB) return a - b;
+  if (op == MUL) return a * b;
+  if (op == DIV) return a / b;
+  return a % b;
+}
+
+// If the code `b[1]` .. `e[0]` computes a constant from immediates, such // 如果程式碼 `b[1]` .. `e[0]` 由立即值計算出常數,
+// as `1`, `-1` or `'a' + 1`, replace it with an `IMM` of the constant and // 例如 `1`, `-1` 或 `'a' + 1`, 將它替換成該常數的 `IMM`
+// return 1, else return 0. The room past `e` holds the pushed values. // 並回傳 1, 否則回傳 0. `e` 之後的空間存放推入的值
+int cfold(int *b)
+{
+  int *s, *t, i, a;
+
+  s = e + 1; t = b; a = 0;
+  if (t == e) return 0;
+  while (t < e) {
+    i = *++t;
+    if (i == IMM) a = *++t;
+    else if (i == ADDI) a = a + *++t;
+    else if (i == PSH) *s++ = a;
+    else if (i >= OR && i <= MOD && (a || (i != DIV && i != MOD))) a = fold(i, *--s, a);
+    else return 0;
+  }
+  e = b; *++e = IMM; *++e = a; li = 0;
+  return 1;
+}
+
+// Drop the code after `b`, compiled for a statement or operand that can // 丟棄 `b` 之後的程式碼, 它屬於永遠不會執行的語句或運算元,
+// never run, along with its lines and `break`s. `-s` has already listed it. // 連同其行和 `break`. `-s` 已經列印過它
+void drop(int *b)
+{
+  while (lnp > lnt && lnp[-2] > b - text) lnp = lnp - 2;
+  if (lmark > b) lmark = b;
+  if (le > b) le = b;
+  while (brks > b) brks = (int *)*brks;
+  e = b; li = tcall = 0;
+}
+
 // Parse expression. // 運算式 expression, 其中 lev 代表優先等級
 // `lev`: Current operator precedence. Greater value means higher precedence.
 // Operator precedence (lower first): // 運算符優先級 (從低到高)
@@ -268,7 +637,10 @@ void next() // 詞彙解析 lexer
 // Brak    [
 void expr(int lev)
 {
-  int t, *d;
+  int t, *b, *d, s, v, o;
+
+  // Point `b` to where the expression's code starts. // 將 `b` 指向運算式的程式碼開始的位置
+  b = e;
 
   // If current token is input end, print error and exit program. // 如果當前 token 是檔案結尾, 則印出錯誤並退出程序
   if (!tk) { printf("%d: unexpected eof in expression\n", line); exit(-1); }
@@ -362,6 +734,7 @@ void expr(int lev)
       // Add `ADJ` instruction and arguments count to instruction buffer to // 添加 `ADJ` 指令和參數計數到指令緩衝區
       // pop arguments off stack after returning from function call. // 以便在從函數呼叫返回後將參數從堆疊中彈出
       if (t) { *++e = ADJ; *++e = t; }
+      if (d[Class] == Fun) tcall = e;
 
       // Set result value type be the system call or function's return type. // 將結果值型態設為系統呼叫或函數的回傳型態
       ty = d[Type];
@@ -386,7 +759,11 @@ void expr(int lev)
       // 2WQE9 // 這裡是原作者用來記錄位置的代碼, 不要上網查他...
       // Add `LC`/`LI` instruction to load the value on the address in register
       // to register. // 添加 `LC`/`LI` 指令來將暫存器中的位址所指向的值載入到暫存器
-      *++e = ((ty = d[Type]) == CHAR) ? LC : LI;
+      // An int-sized variable instead fuses `LEA n; LI` into `LLI n` and // int 大小的變數則將 `LEA n; LI` 融合成 `LLI n`
+      // `IMM x; LI` into `LGI x`. `li` remembers the fused load so that an // 將 `IMM x; LI` 融合成 `LGI x`
+      // lvalue use can take it apart again. // `li` 記住這個融合載入, 讓左值用法可以再把它拆開
+      if ((ty = d[Type]) == CHAR) *++e = LC;
+      else { li = e - 1; *li = (*li == LEA) ? LLI : LGI; }
     }
   }
   // 如果當前 token 是左圓括號, 則他是圓括號中的強制轉換或表達式
@@ -453,9 +830,15 @@ void expr(int lev)
     // 用來獲取變數位址的指令已經被添加到 6S71X 這個位置
     // Only need to remove the `LC`/`LI` instruction added at 2WQE9.
     // 只需要去掉在 2WQE9 處添加的 `LC`/`LI` 指令即可
+    // If current instruction is a fused load, turn `LLI`/`LGI` back into // 如果當前指令是融合載入, 將 `LLI`/`LGI` 還原成
+    // `LEA`/`IMM`. // `LEA`/`IMM`
     // If current instruction is `LC`/`LI`, remove it, else print error and
     // exit program. // 如果當前指令是 `LC`/`LI`, 移除他, 否則印出錯誤並退出程序
-    if (*e == LC || *e == LI) --e; else { printf("%d: bad address-of\n", line); exit(-1); }
+    if (li == e - 1 && (*li == LLI || *li == LGI)) *li = (*li == LLI) ? LEA : IMM;
+    else if (*e == LC || *e == LI) --e; else { printf("%d: bad address-of\n", line); exit(-1); }
+    // A local's address may outlive a tail call, whose callee's frame // 區域變數的位址可能在尾呼叫之後仍被使用,
+    // would overwrite the local. // 而被呼叫者的框架會覆蓋該區域變數
+    if (e[-1] == LEA) laddr = 1;
     // 將結果值型態設為指向當前值型態的指標
     // Set result value type be pointer to current value type.
     ty = ty + PTR;
@@ -464,7 +847,8 @@ void expr(int lev)
   // Add instructions to compute `x == 0` because `!x` is equivalent to
   // `x == 0`. // 添加指令以計算 `x == 0`, 因為 `!x` 等價於 `x == 0`
   // Set result value type be `INT`. // 將結果值型態設為整數
-  else if (tk == '!') { next(); expr(Inc); *++e = PSH; *++e = IMM; *++e = 0; *++e = EQ; ty = INT; }
+  // `li` remembers the `EQ` so that a condition can fuse it with its branch. // `li` 記住這個 `EQ`, 讓條件式可以將它與分支融合
+  else if (tk == '!') { next(); expr(Inc); *++e = PSH; *++e = IMM; *++e = 0; *++e = EQ; li = e; ty = INT; }
   // If current token is `~`, it is bitwise inversion operator. // 如果當前 token 是波浪號, 則他是位元反轉運算符
   // Add instructions to compute `x ^ -1` because `~x` is equivalent to
   // `x ^ -1`. // 添加指令以計算 `x ^ -1`, 因為 `~x` 等價於 `x ^ -1`
@@ -504,38 +888,36 @@ void expr(int lev)
     // Parse operand expression. // 解析運算元表達式
     t = tk; next(); expr(Inc);
 
-    // If current instruction is `LC`, insert a `PSH` instruction before `LC`
-    // 如果當前指令是 `LC`, 在 `LC` 之前插入一個 `PSH` 指令
-    // to push variable address in register to stack for use by the `SC`
-    // 來將暫存器中的變數位址推進堆疊, 供下面添加的 `SC` 指令使用
-    // instruction added below.
-    if (*e == LC) { *e = PSH; *++e = LC; }
-    // If current instruction is `LI`, insert a `PSH` instruction before `LI`
-    // 如果當前指令是 `LI`, 在 `LI` 之前插入一個 `PSH` 指令
-    // to push variable address in register to stack for use by the `SI`
-    // 來將暫存器中的變數位址推進堆疊, 供下面添加的 `SI` 指令使用
-    // instruction added below.
-    else if (*e == LI) { *e = PSH; *++e = LI; }
-    // Else print error and exit program. // 否則印出錯誤並退出程序
-    else { printf("%d: bad lvalue in pre-increment\n", line); exit(-1); }
-
-    // Add `PSH` instruction to push operand value in register to stack
-    // 添加 `PSH` 指令來將暫存器中的運算元推進堆疊
-    // for use by the `ADD`/`SUB` instruction added below.
-    // 供下面添加的 `ADD`/`SUB` 指令使用
-    *++e = PSH;
-
-    // Add `IMM` instruction to load increment/decrement value to register.
-    // 添加 `IMM` 指令來將遞增/遞減值載入到暫存器
-    *++e = IMM; *++e = (ty > PTR) ? sizeof(int) : sizeof(char);
-
-    // Add `ADD`/`SUB` instruction to compute result value.
-    // 添加 `ADD`/`SUB` 指令來計算結果值
-    *++e = (t == Inc) ? ADD : SUB;
-
-    // Add `SC`/`SI` instruction to save result value in register to address
-    // held on stack. // 添加 `SC`/`SI` 指令來將暫存器中的結果值保存到堆疊中的位址
-    *++e = (ty == CHAR) ? SC : SI;
+    // Get the increment/decrement value. // 取得遞增/遞減值
+    v = (ty > PTR) ? sizeof(int) : sizeof(char); if (t == Dec) v = -v;
+
+    // If current instruction is a fused load, add `ADDI` instruction to // 如果當前指令是融合載入, 添加 `ADDI` 指令來計算結果值
+    // compute result value and `SLI`/`SGI` instruction to save it back to // 並添加 `SLI`/`SGI` 指令將其存回變數
+    // the variable.
+    if (li == e - 1 && (*li == LLI || *li == LGI)) { *++e = ADDI; *++e = v; *++e = (*li == LLI) ? SLI : SGI; *++e = li[1]; }
+    else {
+      // If current instruction is `LC`, insert a `PSH` instruction before `LC`
+      // 如果當前指令是 `LC`, 在 `LC` 之前插入一個 `PSH` 指令
+      // to push variable address in register to stack for use by the `SC`
+      // 來將暫存器中的變數位址推進堆疊, 供下面添加的 `SC` 指令使用
+      // instruction added below.
+      if (*e == LC) { *e = PSH; *++e = LC; }
+      // If current instruction is `LI`, insert a `PSH` instruction before `LI`
+      // 如果當前指令是 `LI`, 在 `LI` 之前插入一個 `PSH` 指令
+      // to push variable address in register to stack for use by the `SI`
+      // 來將暫存器中的變數位址推進堆疊, 供下面添加的 `SI` 指令使用
+      // instruction added below.
+      else if (*e == LI) { *e = PSH; *++e = LI; }
+      // Else print error and exit program. // 否則印出錯誤並退出程序
+      else { printf("%d: bad lvalue in pre-increment\n", line); exit(-1); }
+
+      // Add `ADDI` instruction to compute result value. // 添加 `ADDI` 指令來計算結果值
+      *++e = ADDI; *++e = v;
+
+      // Add `SC`/`SI` instruction to save result value in register to address
+      // held on stack. // 添加 `SC`/`SI` 指令來將暫存器中的結果值保存到堆疊中的位址
+      *++e = (ty == CHAR) ? SC : SI;
+    }
   }
   // Else print error and exit program. // 否則印出錯誤並退出程序
   else { printf("%d: bad expression\n", line); exit(-1); }
@@ -548,9 +930,10 @@ void expr(int lev)
 
     // If current token is assignment operator. // 如果當前 token 是賦值運算符 
     if (tk == Assign) {
-      // Read token. // 讀取 token
-      next();
-
+      // If current instruction is a fused load, the variable is an int-sized // 如果當前指令是融合載入, 則變數是 int 大小的區域或全域變數
+      // local or global: remove the load and remember the matching store // 移除該載入指令, 並記住對應的儲存指令 `SLI`/`SGI`
+      // `SLI`/`SGI` in `s` and its operand in `v`. // 放在 `s`, 其運算元放在 `v`
+      // Otherwise `s` is 0 and: // 否則 `s` 為 0, 並且:
       // If current instruction is `LC`/`LI`, current value in register is
       // 如果當前指令是 `LC`/`LI`, 則暫存器中的當前值是變數位址
       // variable address, replace current instruction with `PSH` instruction
@@ -561,44 +944,77 @@ void expr(int lev)
       // 如果當前指令不是 `LC`/`LI`, 則暫存器中的當前值不是變數位址
       // not variable address, print error and exit program.
       // 印出錯誤並退出程序
-      if (*e == LC || *e == LI) *e = PSH; else { printf("%d: bad lvalue in assignment\n", line); exit(-1); }
+      // A compound assignment, operator `o`, keeps the load for its left // 複合賦值 (運算符 `o`) 保留載入作為其左運算元:
+      // operand: the variable's, or after `PSH`, which leaves the address in // 變數的載入, 或是在 `PSH` 之後的載入,
+      // the register, the address's, so the address is computed only once. // `PSH` 會將位址留在暫存器中, 所以位址只計算一次
+      o = ival;
+      if (li == e - 1 && (*li == LLI || *li == LGI)) { s = (*li == LLI) ? SLI : SGI; v = li[1]; if (!o) e = e - 2; }
+      else if (*e == LC || *e == LI) { s = 0; if (o) { v = *e; *e = PSH; *++e = v; } else *e = PSH; }
+      else { printf("%d: bad lvalue in assignment\n", line); exit(-1); }
+
+      // Read token. // 讀取 token
+      next();
 
       // Parse RHS expression. // 解析 RHS 表達式
-      // Add `SC`/`SI` instruction to save value in register to variable
-      // address held on stack. // 添加 `SC`/`SI` 指令來將暫存器中的值保存到堆疊中的變數位址
-      expr(Assign); *++e = ((ty = t) == CHAR) ? SC : SI;
+      // For a compound assignment, push the old value and apply the // 若是複合賦值, 推入舊值並套用運算符,
+      // operator, as `+` and `-` do below: a constant becomes `ADDI` and a // 與下面的 `+` 和 `-` 一樣: 常數變成 `ADDI`,
+      // pointer's offset is scaled by int size. // 指標的位移乘以整數大小
+      // Add `SLI`/`SGI` instruction to save value in register to the variable, // 添加 `SLI`/`SGI` 指令將暫存器中的值保存到變數
+      // or `SC`/`SI` instruction to save value in register to variable
+      // address held on stack. // 或添加 `SC`/`SI` 指令來將暫存器中的值保存到堆疊中的變數位址
+      if (o) { *++e = PSH; d = e; }
+      expr(Assign);
+      if ((o == Add || o == Sub) && e == d + 2 && d[1] == IMM) {
+        *d = ADDI; d[1] = (t > PTR) ? d[2] * sizeof(int) : d[2]; if (o == Sub) d[1] = -d[1]; e = d + 1;
+      }
+      else if (o) {
+        if ((o == Add || o == Sub) && t > PTR) { *++e = PSH; *++e = IMM; *++e = sizeof(int); *++e = MUL; }
+        *++e = o - Or + OR;
+      }
+      if (s) { *++e = s; *++e = v; ty = t; } else *++e = ((ty = t) == CHAR) ? SC : SI;
     }
     // If current token is conditional operator. // 如果當前 token 是條件運算符
     else if (tk == Cond) {
       // Read token. // 讀取 token
       next();
 
-      // Add jump-if-zero instruction `BZ` to jump to false branch. // 添加條件跳轉指令 `BZ` 用來跳轉到假分支
-      // Point `d` to the jump address field to be patched later. // 將 `d` 指向稍後需要修補的跳轉位址字段
-      *++e = BZ; d = ++e;
-
-      // Parse true branch's expression. // 解析真分支的表達式
-      expr(Assign);
-
-      // If current token is not `:`, print error and exit program. // 如果當前 token 不是冒號, 則印出錯誤並退出程序
-      if (tk == ':') next(); else { printf("%d: conditional missing colon\n", line); exit(-1); }
-
-      // Patch the jump address field pointed to by `d` to hold the address of
-      // false branch. // 修補 `d` 指向的跳轉位址字段以保存錯誤分支的位址
-      // `+ 3` counts the `JMP` instruction added below.
-      // 加 3 計算下面添加的 `JMP` 指令
-      // Add `JMP` instruction after the true branch to jump over the false
-      // branch. // 在真分支後面添加 `JMP` 指令, 跳過假分支
-      // Point `d` to the jump address field to be patched later.
-      // 將 `d` 指向稍後需要修補的跳轉位址字段
-      *d = (int)(e + 3); *++e = JMP; d = ++e;
-
-      // Parse false branch's expression. // 解析假分支的表達式
-      expr(Cond);
-
-      // Patch the jump address field pointed to by `d` to hold the address
-      // past the false branch. // 修補 `d` 指向的跳轉位址字段以保存經過錯誤分支的位址
-      *d = (int)(e + 1);
+      // With a constant test, keep only the branch it picks. // 條件為常數時, 只保留它選擇的分支
+      if (cfold(b)) {
+        v = e[0]; e = b;
+        expr(Assign); if (!v) drop(b);
+        if (tk == ':') next(); else { printf("%d: conditional missing colon\n", line); exit(-1); }
+        d = e; expr(Cond); if (v) drop(d);
+      }
+      else {
+        // Add jump-if-zero instruction `BZ` to jump to false branch. // 添加條件跳轉指令 `BZ` 用來跳轉到假分支
+        // Point `d` to the jump address field to be patched later. // 將 `d` 指向稍後需要修補的跳轉位址字段
+        *++e = BZ; d = ++e;
+
+        // Parse true branch's expression. // 解析真分支的表達式
+        expr(Assign);
+
+        // If current token is not `:`, print error and exit program. // 如果當前 token 不是冒號, 則印出錯誤並退出程序
+        if (tk == ':') next(); else { printf("%d: conditional missing colon\n", line); exit(-1); }
+
+        // Patch the jump address field pointed to by `d` to hold the address of
+        // false branch. // 修補 `d` 指向的跳轉位址字段以保存錯誤分支的位址
+        // `+ 3` counts the `JMP` instruction added below.
+        // 加 3 計算下面添加的 `JMP` 指令
+        // Add `JMP` instruction after the true branch to jump over the false
+        // branch. // 在真分支後面添加 `JMP` 指令, 跳過假分支
+        // Point `d` to the jump address field to be patched later.
+        // 將 `d` 指向稍後需要修補的跳轉位址字段
+        *d = (int)(e + 3); *++e = JMP; d = ++e;
+
+        // Parse false branch's expression. // 解析假分支的表達式
+        expr(Cond);
+
+        // Patch the jump address field pointed to by `d` to hold the address
+        // past the false branch. // 修補 `d` 指向的跳轉位址字段以保存經過錯誤分支的位址
+        // A jump now lands after the last compare, so it can't be fused.
+        // 有跳轉落在最後的比較之後，因此不可再融合
+        *d = (int)(e + 1); li = 0;
+      }
     }
     // If current token is logical OR operator. // 如果當前 token 是邏輯或運算符
     // Read token. // 讀取 token
@@ -609,8 +1025,18 @@ void expr(int lev)
     // Parse RHS expression. // 解析 RHS 表達式
     // Patch the jump address field pointed to by `d` to hold the address past
     // the RHS expression. // 修補 `d` 指向的跳轉位址字段以保存經過 RHS 表達式的位址
+    // Forget the last compare since a jump lands right after it.
+    // 忘記最後的比較，因為有跳轉落在其後
     // Set result value type be `INT`. // 將結果值型態設為整數
-    else if (tk == Lor) { next(); *++e = BNZ; d = ++e; expr(Lan); *d = (int)(e + 1); ty = INT; }
+    // A constant LHS decides at compile time: a nonzero one is the value // 常數的 LHS 在編譯時就決定結果: 非零的 LHS 就是結果,
+    // and the RHS is dropped, a zero one is dropped for the RHS. // 並丟棄 RHS; 為零的 LHS 則被丟棄而以 RHS 為結果
+    else if (tk == Lor) {
+      next();
+      if (!cfold(b)) { *++e = BNZ; d = ++e; expr(Lan); *d = (int)(e + 1); }
+      else if (e[0]) { expr(Lan); drop(b + 2); }
+      else { e = b; expr(Lan); }
+      li = 0; ty = INT;
+    }
     // If current token is logical AND operator. // 如果當前 token 是邏輯與運算符
     // Read token. // 讀取 token
     // Add jump-if-zero instruction `BZ` to implement short circuit.
@@ -620,8 +1046,17 @@ void expr(int lev)
     // Parse RHS expression. // 解析 RHS 表達式
     // Patch the jump address field pointed to by `d` to hold the address past
     // the RHS expression. // 修補 `d` 指向的跳轉位址字段以保存經過 RHS 表達式的位址
+    // Forget the last compare since a jump lands right after it.
+    // 忘記最後的比較，因為有跳轉落在其後
     // Set result value type be `INT`. // 將結果值型態設為整數
-    else if (tk == Lan) { next(); *++e = BZ;  d = ++e; expr(Or);  *d = (int)(e + 1); ty = INT; }
+    // A constant LHS decides at compile time, as for `||`. // 常數的 LHS 在編譯時就決定結果, 與 `||` 相同
+    else if (tk == Lan) {
+      next();
+      if (!cfold(b)) { *++e = BZ; d = ++e; expr(Or); *d = (int)(e + 1); }
+      else if (!e[0]) { expr(Or); drop(b + 2); }
+      else { e = b; expr(Or); }
+      li = 0; ty = INT;
+    }
     // If current token is bitwise OR operator. // 如果當前 token 是位元或運算符
     // Read token. // 讀取 token
     // Add `PSH` instruction to push LHS value in register to stack.
@@ -633,12 +1068,14 @@ void expr(int lev)
     else if (tk == Or)  { next(); *++e = PSH; expr(Xor); *++e = OR;  ty = INT; }
     else if (tk == Xor) { next(); *++e = PSH; expr(And); *++e = XOR; ty = INT; }
     else if (tk == And) { next(); *++e = PSH; expr(Eq);  *++e = AND; ty = INT; }
-    else if (tk == Eq)  { next(); *++e = PSH; expr(Lt);  *++e = EQ;  ty = INT; }
-    else if (tk == Ne)  { next(); *++e = PSH; expr(Lt);  *++e = NE;  ty = INT; }
-    else if (tk == Lt)  { next(); *++e = PSH; expr(Shl); *++e = LT;  ty = INT; }
-    else if (tk == Gt)  { next(); *++e = PSH; expr(Shl); *++e = GT;  ty = INT; }
-    else if (tk == Le)  { next(); *++e = PSH; expr(Shl); *++e = LE;  ty = INT; }
-    else if (tk == Ge)  { next(); *++e = PSH; expr(Shl); *++e = GE;  ty = INT; }
+    // For comparisons `li` remembers the compare instruction so that `stmt` // 比較運算時 `li` 記住比較指令
+    // can fuse it with the branch of an `if`/`while`. // 讓 `stmt` 可以將它與 `if`/`while` 的分支融合
+    else if (tk == Eq)  { next(); *++e = PSH; expr(Lt);  *++e = EQ; li = e;  ty = INT; }
+    else if (tk == Ne)  { next(); *++e = PSH; expr(Lt);  *++e = NE; li = e;  ty = INT; }
+    else if (tk == Lt)  { next(); *++e = PSH; expr(Shl); *++e = LT; li = e;  ty = INT; }
+    else if (tk == Gt)  { next(); *++e = PSH; expr(Shl); *++e = GT; li = e;  ty = INT; }
+    else if (tk == Le)  { next(); *++e = PSH; expr(Shl); *++e = LE; li = e;  ty = INT; }
+    else if (tk == Ge)  { next(); *++e = PSH; expr(Shl); *++e = GE; li = e;  ty = INT; }
     else if (tk == Shl) { next(); *++e = PSH; expr(Add); *++e = SHL; ty = INT; }
     else if (tk == Shr) { next(); *++e = PSH; expr(Add); *++e = SHR; ty = INT; }
     // If current token is addition operator. // 如果當前 token 是加法運算符
@@ -647,22 +1084,29 @@ void expr(int lev)
       // Add `PSH` instruction to push LHS value in register to stack.
       // 添加 `PSH` 指令來將暫存器中的 LHS 值推進堆疊
       // Parse RHS expression. // 解析 RHS 表達式
-      next(); *++e = PSH; expr(Mul);
-
-      // If LHS value type is pointer, // 如果 LHS 值型態是指標
-      // the RHS value should be multiplied by int size to get address offset.
-      // 則 RHS 值應該乘以整數大小來獲得位址偏移量
-      // Add `PSH` instruction to push RHS value in register to stack.
-      // 添加 `PSH` 指令來將暫存器中的 RHS 值推進堆疊
-      // Add `IMM` instruction to load int size to register.
-      // 添加 `IMM` 指令來將整數大小載入到暫存器
-      // Add `MUL` instruction to multiply RHS value on stack by int size in
-      // register to get the address offset. // 添加 `MUL` 指令來將堆疊中的 RHS 值乘以暫存器中的整數大小, 以獲得位址偏移量
-      if ((ty = t) > PTR) { *++e = PSH; *++e = IMM; *++e = sizeof(int); *++e = MUL;  }
+      // Point `d` to the `PSH` instruction. // 將 `d` 指向 `PSH` 指令
+      next(); *++e = PSH; d = e; expr(Mul);
 
-      // Add addition instruction to add LHS value on stack to RHS value in
-      // register. // 添加加法指令來將堆疊中的 LHS 值加上暫存器中的 RHS 值
-      *++e = ADD;
+      // If RHS expression is a single `IMM` instruction, replace // 如果 RHS 表達式只有一個 `IMM` 指令
+      // `PSH; IMM k` with `ADDI k`, scaled by int size if LHS value type is // 就將 `PSH; IMM k` 替換成 `ADDI k`
+      // pointer. // 若 LHS 值型態是指標, 則乘以整數大小
+      if (e == d + 2 && d[1] == IMM) { v = d[2]; *d = ADDI; d[1] = ((ty = t) > PTR) ? v * sizeof(int) : v; e = d + 1; }
+      else {
+        // If LHS value type is pointer, // 如果 LHS 值型態是指標
+        // the RHS value should be multiplied by int size to get address offset.
+        // 則 RHS 值應該乘以整數大小來獲得位址偏移量
+        // Add `PSH` instruction to push RHS value in register to stack.
+        // 添加 `PSH` 指令來將暫存器中的 RHS 值推進堆疊
+        // Add `IMM` instruction to load int size to register.
+        // 添加 `IMM` 指令來將整數大小載入到暫存器
+        // Add `MUL` instruction to multiply RHS value on stack by int size in
+        // register to get the address offset. // 添加 `MUL` 指令來將堆疊中的 RHS 值乘以暫存器中的整數大小, 以獲得位址偏移量
+        if ((ty = t) > PTR) { *++e = PSH; *++e = IMM; *++e = sizeof(int); *++e = MUL;  }
+
+        // Add addition instruction to add LHS value on stack to RHS value in
+        // register. // 添加加法指令來將堆疊中的 LHS 值加上暫存器中的 RHS 值
+        *++e = ADD;
+      }
     }
     // If current token is subtraction operator. // 如果當前 token 是減法運算符
     else if (tk == Sub) {
@@ -670,7 +1114,8 @@ void expr(int lev)
       // Add `PSH` instruction to push LHS value in register to stack.
       // 添加 `PSH` 指令來將暫存器中的 LHS 值推進堆疊
       // Parse RHS expression. // 解析 RHS 表達式
-      next(); *++e = PSH; expr(Mul);
+      // Point `d` to the `PSH` instruction. // 將 `d` 指向 `PSH` 指令
+      next(); *++e = PSH; d = e; expr(Mul);
       // If LHS value type is pointer and RHS value type is pointer,
       // 如果 LHS 值型態是指標且 RHS 值型態是指標
       // the subtraction result should be divided by int size to get int-size
@@ -685,6 +1130,10 @@ void expr(int lev)
       // int size in register to get int-size difference.
       // 添加 `DIV` 指令來將堆疊中的位址差異除以暫存器中的整數大小, 以獲得整數大小的差異
       if (t > PTR && t == ty) { *++e = SUB; *++e = PSH; *++e = IMM; *++e = sizeof(int); *++e = DIV; ty = INT; }
+      // If RHS expression is a single `IMM` instruction, replace // 如果 RHS 表達式只有一個 `IMM` 指令
+      // `PSH; IMM k` with `ADDI -k`, scaled by int size if LHS value type is // 就將 `PSH; IMM k` 替換成 `ADDI -k`
+      // pointer. // 若 LHS 值型態是指標, 則乘以整數大小
+      else if (e == d + 2 && d[1] == IMM) { v = d[2]; *d = ADDI; d[1] = ((ty = t) > PTR) ? -v * sizeof(int) : -v; e = d + 1; }
       // If LHS value type is pointer and RHS value type is not pointer,
       // 如果 LHS 值型態不是指標且 RHS 值型態不是指標
       // the RHS value should be multiplied by int size to get address offset.
@@ -717,46 +1166,43 @@ void expr(int lev)
     // If current token is postfix increment or decrement operator.
     // 如果當前 token 是後置遞增或遞減運算符
     else if (tk == Inc || tk == Dec) {
-      // If current instruction is `LC`, insert a `PSH` instruction before `LC`
-      // 如果當前指令是 `LC`, 在 `LC` 之前插入一個 `PSH` 指令
-      // to push variable address in register to stack for use by the `SC`
-      // 來將暫存器中的變數位址推進堆疊, 供下面添加的 `SC` 指令使用
-      // instruction added below.
-      if (*e == LC) { *e = PSH; *++e = LC; }
-      // If current instruction is `LI`, insert a `PSH` instruction before `LI`
-      // 如果當前指令是 `LI`, 在 `LI` 之前插入一個 `PSH` 指令
-      // to push variable address in register to stack for use by the `SI`
-      // 來將暫存器中的變數位址推進堆疊, 供下面添加的 `SI` 指令使用
-      // instruction added below.
-      else if (*e == LI) { *e = PSH; *++e = LI; }
-      // Else print error and exit program. // 否則印出錯誤並退出程序
-      else { printf("%d: bad lvalue in post-increment\n", line); exit(-1); }
-
-      // Add `PSH` instruction to push operand value in register to stack.
-      // 添加 `PSH` 指令來將暫存器中的運算元推進堆疊
-      // Add `IMM` instruction to load increment/decrement size to register.
-      // 添加 `IMM` 指令來將遞增/遞減大小載入到暫存器中
-      *++e = PSH; *++e = IMM; *++e = (ty > PTR) ? sizeof(int) : sizeof(char);
-
-      // Add `ADD`/`SUB` instruction to compute the post value.
-      // 添加 `ADD`/`SUB` 指令來計算後置值
-      *++e = (tk == Inc) ? ADD : SUB;
+      // Get the increment/decrement value. // 取得遞增/遞減值
+      v = (ty > PTR) ? sizeof(int) : sizeof(char); if (tk == Dec) v = -v;
 
-      // Add `SC`/`SI` instruction to save the post value in register to
-      // variable. // 添加 `SC`/`SI` 指令來將暫存器中的後置值保存到變數中
-      *++e = (ty == CHAR) ? SC : SI;
-
-      // Add `PSH` instruction to push the post value in register to stack.
-      // 添加 `PSH` 指令來將暫存器中的後置值推進堆疊
-      // Add `IMM` instruction to load increment/decrement size to register.
-      // 添加 `IMM` 指令來將遞增/遞減大小載入到暫存器中
-      *++e = PSH; *++e = IMM; *++e = (ty > PTR) ? sizeof(int) : sizeof(char);
+      // If current instruction is a fused load, add `ADDI` instruction to // 如果當前指令是融合載入, 添加 `ADDI` 指令來計算後置值
+      // compute the post value and `SLI`/`SGI` instruction to save it to the // 並添加 `SLI`/`SGI` 指令將其保存到變數中
+      // variable.
+      if (li == e - 1 && (*li == LLI || *li == LGI)) { *++e = ADDI; *++e = v; *++e = (*li == LLI) ? SLI : SGI; *++e = li[1]; }
+      else {
+        // If current instruction is `LC`, insert a `PSH` instruction before `LC`
+        // 如果當前指令是 `LC`, 在 `LC` 之前插入一個 `PSH` 指令
+        // to push variable address in register to stack for use by the `SC`
+        // 來將暫存器中的變數位址推進堆疊, 供下面添加的 `SC` 指令使用
+        // instruction added below.
+        if (*e == LC) { *e = PSH; *++e = LC; }
+        // If current instruction is `LI`, insert a `PSH` instruction before `LI`
+        // 如果當前指令是 `LI`, 在 `LI` 之前插入一個 `PSH` 指令
+        // to push variable address in register to stack for use by the `SI`
+        // 來將暫存器中的變數位址推進堆疊, 供下面添加的 `SI` 指令使用
+        // instruction added below.
+        else if (*e == LI) { *e = PSH; *++e = LI; }
+        // Else print error and exit program. // 否則印出錯誤並退出程序
+        else { printf("%d: bad lvalue in post-increment\n", line); exit(-1); }
+
+        // Add `ADDI` instruction to compute the post value.
+        // 添加 `ADDI` 指令來計算後置值
+        *++e = ADDI; *++e = v;
+
+        // Add `SC`/`SI` instruction to save the post value in register to
+        // variable. // 添加 `SC`/`SI` 指令來將暫存器中的後置值保存到變數中
+        *++e = (ty == CHAR) ? SC : SI;
+      }
 
-      // Add `SUB`/`ADD` instruction to compute the old value.
-      // 添加 `SUB`/`ADD` 指令來計算舊值
+      // Add `ADDI` instruction to compute the old value.
+      // 添加 `ADDI` 指令來計算舊值
       // This implements postfix semantics.
       // 這實現了後置語義
-      *++e = (tk == Inc) ? SUB : ADD;
+      *++e = ADDI; *++e = -v;
 
       // Read token. // 讀取 token
       next();
@@ -767,31 +1213,39 @@ void expr(int lev)
       // Add `PSH` instruction to push the base address in register to stack.
       // 添加 `PSH` 指令來將暫存器中的基底位址推進堆疊
       // Parse subscript expression. // 解析索引表達式
-      next(); *++e = PSH; expr(Assign);
+      // Point `d` to the `PSH` instruction. // 將 `d` 指向 `PSH` 指令
+      next(); *++e = PSH; d = e; expr(Assign);
 
       // If current token is not `]`, print error and exit program. // 如果當前 token 不是右方括號, 印出錯誤並退出程序
       if (tk == ']') next(); else { printf("%d: close bracket expected\n", line); exit(-1); }
 
-      // If base address's value type is int pointer or pointer to pointer,
-      // 如果基底位址的值型態是整數指標或雙重指標
-      // the subscript value should be multiplied by int size to get address
-      // 則索引值應該乘以整數大小以獲得位址偏移量
-      // offset. `t == PTR` is char pointer `char*`, which needs not doing so.
-      // `t == PTR` 是字元指標 `char*`, 不需要進行這樣的操作
-      // Add `PSH` instruction to push subscript value in register to stack.
-      // 添加 `PSH` 指令來將暫存器中的索引值推進堆疊
-      // Add `IMM` instruction to load int size to register.
-      // 添加 `IMM` 指令來將整數大小載入到暫存器
-      // Add `MUL` instruction to compute address offset.
-      // 添加 `MUL` 指令來計算位址偏移量
-      if (t > PTR) { *++e = PSH; *++e = IMM; *++e = sizeof(int); *++e = MUL;  }
       // If base address's value type is not pointer, print error and exit
       // program. // 如果基底位址的值型態不是指標, 印出錯誤並退出程序
-      else if (t < PTR) { printf("%d: pointer type expected\n", line); exit(-1); }
+      if (t < PTR) { printf("%d: pointer type expected\n", line); exit(-1); }
 
-      // Add `ADD` instruction to add the address offset to the base address.
-      // 添加 `ADD` 指令來將位址偏移量加到基底位址上
-      *++e = ADD;
+      // If subscript expression is a single `IMM` instruction, replace // 如果索引表達式只有一個 `IMM` 指令
+      // `PSH; IMM k` with `ADDI k`, scaled by int size unless base address's // 就將 `PSH; IMM k` 替換成 `ADDI k`
+      // value type is `char*`. // 除非基底位址的值型態是 `char*`, 否則乘以整數大小
+      if (e == d + 2 && d[1] == IMM) { v = d[2]; *d = ADDI; d[1] = (t > PTR) ? v * sizeof(int) : v; e = d + 1; }
+      else {
+        // If base address's value type is int pointer or pointer to pointer,
+        // 如果基底位址的值型態是整數指標或雙重指標
+        // the subscript value should be multiplied by int size to get address
+        // 則索引值應該乘以整數大小以獲得位址偏移量
+        // offset. `t == PTR` is char pointer `char*`, which needs not doing so.
+        // `t == PTR` 是字元指標 `char*`, 不需要進行這樣的操作
+        // Add `PSH` instruction to push subscript value in register to stack.
+        // 添加 `PSH` 指令來將暫存器中的索引值推進堆疊
+        // Add `IMM` instruction to load int size to register.
+        // 添加 `IMM` 指令來將整數大小載入到暫存器
+        // Add `MUL` instruction to compute address offset.
+        // 添加 `MUL` 指令來計算位址偏移量
+        if (t > PTR) { *++e = PSH; *++e = IMM; *++e = sizeof(int); *++e = MUL;  }
+
+        // Add `ADD` instruction to add the address offset to the base address.
+        // 添加 `ADD` 指令來將位址偏移量加到基底位址上
+        *++e = ADD;
+      }
 
       // Add `LC`/`LI` instruction to load the value on the address in register
       // to register. // 添加 `LC`/`LI` 指令來將暫存器中的位址所指向的值載入到暫存器
@@ -803,10 +1257,163 @@ void expr(int lev)
   }
 }
 
+// Return nonzero if opcode `i` has a code address operand. // 若操作碼 `i` 的運算元是程式碼位址則回傳非零
+int isjmp(int i) { return i == JMP || i == JSR || i == TJSR || i == BZ || i == BNZ || (i >= BEQ && i <= BGE); }
+
+// Move the code at `f` .. `g - 1` after the code at `g` .. `e`, which must // 將 `f` .. `g - 1` 的程式碼移到 `g` .. `e` 的程式碼之後,
+// not jump into it, as `for` does with its increment. Jumps, the line // 後者不能跳入前者, `for` 對其遞增部分就是這樣做的
+// table and the marks of what was recorded and listed follow the code. // 跳轉、行表以及已記錄和已列印的標記都跟著程式碼移動
+void sink(int *f, int *g)
+{
+  int *t, n, m;
+
+  n = g - f; m = e + 1 - g;
+  if (!n || !m) return;
+  if (e + n > tlim) { printf("%d: text area full\n", line); exit(-1); }
+
+  // Fix the jumps within each part, including those to its end, then swap // 修正每個部分內的跳轉, 包括跳到其結尾的,
+  // the parts through the room past `e`. // 然後透過 `e` 之後的空間交換兩個部分
+  t = f;
+  while (t <= e) {
+    if (isjmp(*t) && *t != JSR && *t != TJSR) {
+      if (t < g && (int *)t[1] >= f && (int *)t[1] <= g) t[1] = t[1] + m * sizeof(int);
+      else if (t >= g && (int *)t[1] >= g && (int *)t[1] <= e + 1) t[1] = t[1] - n * sizeof(int);
+    }
+    t = t + (*t <= BGE ? 2 : 1);
+  }
+  t = f; while (t < g) { t[m + n] = *t; ++t; }
+  t = f; while (t <= e) { *t = t[n]; ++t; }
+
+  // Case labels and the default of the innermost switch recorded in `g` // 最內層 switch 在 `g` .. `e` 中記錄的 case 標籤和 default
+  // .. `e` move back with it. // 隨之往回移
+  if (swb) {
+    t = swb + 1;
+    while (t < swp) { if ((int *)*t >= g && (int *)*t <= e + 1) *t = *t - n * sizeof(int); t = t + 2; }
+  }
+  if (swd >= g && swd <= e + 1) swd = swd - n;
+
+  // Lines that start in the moved code start where it ends up; the ones // 起始於被移動程式碼中的行, 改為起始於其新位置;
+  // after move back with the rest. Unless the marks cover all of the code, // 之後的行隨其餘部分往回移
+  // they fall back to cover none of the moved code. // 除非標記涵蓋了全部程式碼, 否則退回到不涵蓋被移動的程式碼
+  t = lnp;
+  while (t > lnt && t[-2] >= f - text) { t = t - 2; *t = (*t < g - text) ? f - text : *t - n; }
+  if (lmark < e) { if (lmark >= g) lmark = lmark - n; else if (lmark >= f) lmark = f - 1; }
+  if (le < e) { if (le >= g) le = le - n; else if (le >= f) le = f - 1; }
+  li = tcall = 0;
+}
+
+// Add jump-if-zero instruction `BZ` for the test expression just parsed. // 為剛解析完的條件運算式添加條件跳轉指令 `BZ`
+// Return the address of its jump address field, to be patched later. // 回傳其跳轉位址欄位的位址, 以便稍後修補
+// If the test ends with a compare (see `li`), fuse the two instead: // 如果條件運算式以比較指令結尾 (見 `li`), 則將兩者融合:
+// `LT; BZ` becomes `BGE`, and so on; `PSH; IMM 0; EQ; BZ` (`x == 0`, `!x`) // `LT; BZ` 變成 `BGE`, 依此類推; `PSH; IMM 0; EQ; BZ` (`x == 0`, `!x`)
+// becomes `BNZ` and `PSH; IMM 0; NE; BZ` (`x != 0`) becomes `BZ`. // 變成 `BNZ`, 而 `PSH; IMM 0; NE; BZ` (`x != 0`) 變成 `BZ`
+int *bz()
+{
+  int i;
+
+  // If current instruction is not a compare, add `BZ`. // 如果當前指令不是比較指令, 添加 `BZ`
+  if (li != e || *e < EQ || *e > GE) *++e = BZ;
+  // Compare with 0: drop `PSH; IMM 0` and test the value itself. // 與 0 比較: 去掉 `PSH; IMM 0`, 直接測試值本身
+  else if ((*e == EQ || *e == NE) && e[-3] == PSH && e[-2] == IMM && e[-1] == 0) { i = *e; e = e - 3; *e = (i == EQ) ? BNZ : BZ; }
+  // Replace the compare with the branch taken when it is false. // 將比較指令替換成比較結果為假時跳轉的分支指令
+  else *e = (*e == EQ) ? BNE : (*e == NE) ? BEQ : (*e == LT) ? BGE : (*e == GT) ? BLE : (*e == LE) ? BGT : BLT;
+
+  return ++e;
+}
+
+// Move the code at `f` .. `e` up `n` words to make room in front of it, as // 將 `f` .. `e` 的程式碼上移 `n` 個字組, 在其前面騰出空間,
+// `switch` does for its dispatch. Jumps within it, the line table and the // `switch` 為其分派就是這樣做的. 其中的跳轉、行表
+// marks follow the code, and what it listed is listed again. // 以及標記都跟著程式碼移動, 而已列印的部分會再列印一次
+void lift(int *f, int n)
+{
+  int *t;
+
+  if (e + n > tlim) { printf("%d: text area full\n", line); exit(-1); }
+  t = e; while (t >= f) { t[n] = *t; --t; }
+  e = e + n; t = f + n;
+  while (t <= e) {
+    if (isjmp(*t) && *t != JSR && *t != TJSR && (int *)t[1] >= f && (int *)t[1] <= e + 1 - n) t[1] = t[1] + n * sizeof(int);
+    t = t + (*t <= BGE ? 2 : 1);
+  }
+  t = lnp;
+  while (t > lnt && t[-2] >= f - text) { t = t - 2; *t = *t + n; }
+  if (lmark >= f) lmark = lmark + n;
+  if (le >= f) le = f - 1;
+  li = tcall = 0;
+}
+
+// Point the `break`s of the loop or `switch` just compiled at `e + 1`, // 將剛編譯完的迴圈或 switch 的 `break` 指向 `e + 1`,
+// and go back to the enclosing one's, linked from `b`. // 並回到外層的, 由 `b` 鏈結的 `break`
+void brkend(int *b)
+{
+  int *t;
+
+  while (brks) { t = (int *)*brks; *brks = (int)(e + 1); brks = t; }
+  brks = b; --nbrk;
+}
+
+// Sort the `n` (value, address) case pairs at `c` by value, and stop with // 依數值排序 `c` 的 `n` 個 (數值, 位址) case 對,
+// an error at a repeated value. // 遇到重複的數值時以錯誤停止
+void swsort(int *c, int n)
+{
+  int i, j, v, t;
+
+  i = 1;
+  while (i < n) {
+    v = c[i * 2]; t = c[i * 2 + 1]; j = i;
+    while (j > 0 && c[j * 2 - 2] > v) { c[j * 2] = c[j * 2 - 2]; c[j * 2 + 1] = c[j * 2 - 1]; --j; }
+    if (j > 0 && c[j * 2 - 2] == v) { printf("%d: duplicate case value\n", line); exit(-1); }
+    c[j * 2] = v; c[j * 2 + 1] = t; ++i;
+  }
+}
+
+enum { Jmin = 4 }; // fewest cases worth a jump table // 值得使用跳躍表的最少 case 數量
+
+// Return nonzero if the `n` sorted cases at `c` fill at least about half // 若排序於 `c` 的 `n` 個 case 至少大約填滿其範圍的一半,
+// of their range and are enough for a jump table. The ends are halved so // 且數量足以使用跳躍表, 則回傳非零
+// that their difference cannot overflow. // 兩端先減半, 所以其差值不會溢位
+int swdense(int *c, int n) { return n >= Jmin && (c[n * 2 - 2] >> 1) - (*c >> 1) < n; }
+
+// Emit the dispatch of a `switch` to the `n` cases sorted at `c`: jump to // 輸出 `switch` 到排序於 `c` 的 `n` 個 case 的分派:
+// the address of the one equal to the value, else to `d`. The addresses // 跳到與值相等者的位址, 否則跳到 `d`
+// are taken `m` words up, where the body is lifted to. The value is in // 位址取上移 `m` 個字組之後的, 也就是主體被上移到的位置
+// `a` if `s` is 0, else in local `s`. A dense run of cases indexes a // 值在 `a` 中 (若 `s` 為 0), 否則在區域變數 `s` 中
+// `JTAB`, a few are compared in turn, and more are split in half, so the // 密集的 case 以 `JTAB` 索引, 少數的逐一比較, 更多的則對半分割,
+// sparse ones are found by binary search. // 所以稀疏的 case 以二分搜尋找到
+void swgen(int *c, int n, int *d, int s, int m)
+{
+  int *b, k, v;
+
+  if (swdense(c, n)) {
+    if (s) { *++e = LLI; *++e = s; }
+    if (*c) { *++e = ADDI; *++e = -*c; }
+    k = c[n * 2 - 2] - *c + 1; v = *c;
+    *++e = JTAB; *++e = k;
+    while (k--) {
+      *++e = JMP;
+      if (*c == v) { *++e = (int)((int *)c[1] + m); c = c + 2; } else *++e = (int)(d + m);
+      ++v;
+    }
+    *++e = JMP; *++e = (int)(d + m);
+  }
+  else if (n < Jmin) {
+    while (n--) { *++e = LLI; *++e = s; *++e = PSH; *++e = IMM; *++e = *c; *++e = BEQ; *++e = (int)((int *)c[1] + m); c = c + 2; }
+    *++e = JMP; *++e = (int)(d + m);
+  }
+  // Values below the middle case's go to the second half. // 小於中間 case 的值跳到後半部
+  else {
+    k = n / 2;
+    *++e = LLI; *++e = s; *++e = PSH; *++e = IMM; *++e = c[k * 2]; *++e = BLT; b = ++e;
+    swgen(c + k * 2, n - k, d, s, m);
+    *b = (int)(e + 1);
+    swgen(c, k, d, s, m);
+  }
+}
+
 // Parse statement. // 解析語句
 void stmt()
 {
-  int *a, *b;
+  int *a, *b, *c, *d, *f, *g, *h, n, m, v;
 
   // If current token is `if`. // 如果當前 token 是 if
   if (tk == If) {
@@ -817,17 +1424,24 @@ void stmt()
     if (tk == '(') next(); else { printf("%d: open paren expected\n", line); exit(-1); }
 
     // Parse test expression. // 解析條件運算式
-    expr(Assign);
-
-    // If current token is not `)`, print error and exit program. // 如果當前 token 不是 ')', 則印出錯誤並退出程式
-    if (tk == ')') next(); else { printf("%d: close paren expected\n", line); exit(-1); }
+    // `n` is 1 if it is a nonzero constant, -1 if it is 0, else 0. // 如果它是非零常數, `n` 為 1, 是 0 則為 -1, 否則為 0
+    a = e; expr(Assign);
+    n = 0; if (cfold(a)) n = e[0] ? 1 : -1;
 
     // Add jump-if-zero instruction `BZ` to jump over the true branch. // 添加條件跳轉指令 BZ 以跳過 true 區塊
     // Point `b` to the jump address field to be patched later. // 將 b 指向待修補的跳轉位址欄位
-    *++e = BZ; b = ++e;
+    // A nonzero constant test needs neither. // 非零的常數條件兩者都不需要
+    if (n > 0) { e = a; b = 0; } else b = bz();
+
+    // If current token is not `)`, print error and exit program. // 如果當前 token 不是 ')', 則印出錯誤並退出程式
+    if (tk == ')') next(); else { printf("%d: close paren expected\n", line); exit(-1); }
 
     // Parse true branch's statement. // 解析 true 區塊的語句
+    // If the test is 0, drop it with the test, unless a `case` or // 如果條件為 0, 將它連同條件一起丟棄,
+    // `default` in it can still reach it. // 除非其中的 `case` 或 `default` 仍能到達它
+    g = swp; h = swd;
     stmt();
+    if (n < 0 && swp == g && swd == h) { drop(a); b = 0; }
 
     // If current token is `else`. // 如果當前 token 是 else
     if (tk == Else) {
@@ -835,17 +1449,21 @@ void stmt()
       // `e + 3` excludes the `JMP` instruction added below. // e + 3 是因為還會再插入一個 JMP
       // Add `JMP` instruction after the true branch to jump over the else branch. // 在 true 區塊後插入 JMP 以跳過 else 區塊
       // Point `b` to the jump address field to be patched later. // b 指向新的跳轉位址欄位 (for else 區塊結束)
-      *b = (int)(e + 3); *++e = JMP; b = ++e;
+      // A dropped true branch needs no `JMP`. // 被丟棄的 true 區塊不需要 JMP
+      if (b || n > 0) { if (b) *b = (int)(e + 3); *++e = JMP; b = ++e; }
 
       // Read token. // 讀取 token
       next();
 
       // Parse else branch's statement. // 解析 else 區塊的語句
+      // If the test is nonzero, drop it with its `JMP`, as above. // 如果條件非零, 將它連同其 JMP 一起丟棄, 同上
+      g = swp; h = swd;
       stmt();
+      if (n > 0 && swp == g && swd == h) { drop(b - 2); b = 0; }
     }
 
     // Patch the jump address field pointed to by `b` to hold the address past the if-else structure. // 修補 b 所指向的跳轉位址為 if-else 區塊後的下一行指令
-    *b = (int)(e + 1);
+    if (b) *b = (int)(e + 1);
   }
   // If current token is `while`. // 如果當前 token 是 while
   else if (tk == While) {
@@ -858,24 +1476,148 @@ void stmt()
     // If current token is not `(`, print error and exit program. // 如果 token 不是 '(', 印出錯誤並退出
     if (tk == '(') next(); else { printf("%d: open paren expected\n", line); exit(-1); }
 
-    // Parse test expression. // 解析條件運算式
+    // Parse test expression, with `n` as for `if`. // 解析條件運算式, `n` 與 if 相同
     expr(Assign);
-
-    // If current token is not `)`, print error and exit program. // 如果 token 不是 ')', 印出錯誤並退出
-    if (tk == ')') next(); else { printf("%d: close paren expected\n", line); exit(-1); }
+    n = 0; if (cfold(a - 1)) n = e[0] ? 1 : -1;
 
     // Add jump-if-zero instruction `BZ` to jump over loop body. // 插入條件跳轉指令 BZ 來跳過 while 迴圈的主體
     // Point `b` to the jump address field to be patched later. // b 為待修補的跳轉地址
-    *++e = BZ; b = ++e;
+    // A nonzero constant test needs neither, and the loop starts at its body. // 非零的常數條件兩者都不需要, 迴圈從其主體開始
+    if (n > 0) { e = a - 1; b = 0; } else b = bz();
+
+    // If current token is not `)`, print error and exit program. // 如果 token 不是 ')', 印出錯誤並退出
+    if (tk == ')') next(); else { printf("%d: close paren expected\n", line); exit(-1); }
 
-    // Parse loop body's statement. // 解析 while 主體
+    // Parse loop body's statement, with its own `break`s. // 解析 while 主體, 它有自己的 break
+    c = brks; brks = 0; ++nbrk;
+    g = swp; h = swd;
     stmt();
 
     // Add `JMP` instruction to jump to test expression. // 插入 JMP 回到 while 條件開始處
     *++e = JMP; *++e = (int)a;
 
     // Patch the jump address field pointed to by `b` to hold the address past the loop structure. // 修補 b 所指向的跳轉地址為 while 區塊之後的地址
-    *b = (int)(e + 1);
+    // Point the `break`s there too. // `break` 也指向那裡
+    // If the test is 0, drop the loop, unless a `case` or `default` in it // 如果條件為 0, 丟棄整個迴圈,
+    // can still reach it. // 除非其中的 `case` 或 `default` 仍能到達它
+    if (b) *b = (int)(e + 1);
+    if (n < 0 && swp == g && swd == h) drop(a - 1);
+    brkend(c);
+  }
+  // If current token is `for`. // 如果當前 token 是 for
+  // `for (x; c; y) s` is `x; while (c) { s y; }`, with the code of `y` // `for (x; c; y) s` 就是 `x; while (c) { s y; }`,
+  // moved below that of `s`. Each part may be empty, and no `c` is true. // `y` 的程式碼被移到 `s` 的之下. 每個部分都可以省略, 省略 `c` 表示真
+  else if (tk == For) {
+    // Read token. // 讀取 token
+    next();
+
+    // If current token is not `(`, print error and exit program. // 如果 token 不是 '(', 印出錯誤並退出
+    if (tk == '(') next(); else { printf("%d: open paren expected\n", line); exit(-1); }
+
+    // Parse initialization expression. // 解析初始化運算式
+    if (tk != ';') expr(Assign);
+    if (tk == ';') next(); else { printf("%d: semicolon expected\n", line); exit(-1); }
+
+    // Point `a` to the test expression's address, and `b` to the jump // `a` 指向條件運算式的位置,
+    // address field of its `BZ`, if any. `n` is as for `while`, and a // `b` 指向其 `BZ` 的跳轉位址欄位 (若有)
+    // nonzero constant test is dropped like a missing one. // `n` 與 while 相同, 非零的常數條件像省略的條件一樣被丟棄
+    a = e + 1; b = 0; n = 0;
+    if (tk != ';') {
+      expr(Assign);
+      if (cfold(a - 1)) n = e[0] ? 1 : -1;
+      if (n > 0) e = a - 1; else b = bz();
+    }
+    if (tk == ';') next(); else { printf("%d: semicolon expected\n", line); exit(-1); }
+
+    // Parse increment expression; `c` is where its code starts. // 解析遞增運算式; `c` 是其程式碼的開始位置
+    c = e + 1;
+    if (tk != ')') expr(Assign);
+    if (tk == ')') next(); else { printf("%d: close paren expected\n", line); exit(-1); }
+
+    // Parse loop body's statement, with its own `break`s, then move the // 解析迴圈主體的語句, 它有自己的 break,
+    // increment below it. // 然後把遞增部分移到其下
+    f = brks; brks = 0; ++nbrk;
+    g = swp; h = swd;
+    d = e + 1; stmt(); sink(c, d);
+    if (brks) brks = brks - (d - c);
+
+    // Add `JMP` instruction to jump to test expression. // 插入 JMP 回到條件運算式
+    // Patch the `BZ` and the `break`s to jump past the loop structure. // 修補 `BZ` 和 `break` 跳到迴圈結構之後
+    // A test of 0 drops the loop as for `while`. // 條件為 0 時與 while 一樣丟棄迴圈
+    *++e = JMP; *++e = (int)a;
+    if (b) *b = (int)(e + 1);
+    if (n < 0 && swp == g && swd == h) drop(a - 1);
+    brkend(f);
+  }
+  // If current token is `switch`. // 如果當前 token 是 switch
+  // Its dispatch is only known once the body has been parsed, so it is // 其分派要到主體解析完後才知道,
+  // emitted then, and the body is lifted to make room for it in front. // 所以在那時才輸出, 並上移主體以在其前面騰出空間
+  else if (tk == Switch) {
+    // Read token. // 讀取 token
+    next();
+
+    // Parse the value between parentheses. // 解析括號中的值
+    if (tk == '(') next(); else { printf("%d: open paren expected\n", line); exit(-1); }
+    expr(Assign);
+    if (tk == ')') next(); else { printf("%d: close paren expected\n", line); exit(-1); }
+
+    // Parse the body, with its own cases, default and `break`s. // 解析主體, 它有自己的 case、default 和 break
+    a = swb; b = swd; c = brks; swb = swp; swd = 0; brks = 0; ++nbrk;
+    d = e + 1; stmt();
+
+    // A value that matches no case and no default goes past the body. The // 不符合任何 case 且沒有 default 的值跳過主體
+    // dispatch indexes one table with `a`, or keeps the value in a new local. // 分派以 `a` 索引一個表格, 或將值保存在新的區域變數中
+    if (!swd) swd = e + 1;
+    n = (swp - swb) / 2; swsort(swb, n);
+    v = 0; if (n && !swdense(swb, n)) v = -++fent[1];
+    if (e + n * 16 + 16 > tlim) { printf("%d: text area full\n", line); exit(-1); }
+
+    // Emit the dispatch past the body to measure it, then lift the body // 先在主體之後輸出分派以量測其大小,
+    // that far and emit the dispatch for real in front of it. // 再將主體上移同樣的距離, 並在其前面正式輸出分派
+    f = e;
+    if (v) { *++e = SLI; *++e = v; }
+    swgen(swb, n, swd, v, 0);
+    m = e - f; e = f; lift(d, m);
+    if (brks) brks = brks + m;
+    f = e; e = d - 1;
+    if (v) { *++e = SLI; *++e = v; }
+    swgen(swb, n, swd, v, m);
+    e = f;
+
+    // Point the `break`s past the body and restore the enclosing switch. // 將 `break` 指向主體之後, 並還原外層的 switch
+    swp = swb; swb = a; swd = b;
+    brkend(c);
+  }
+  // If current token is `case` or `default`, it labels the statement that // 如果當前 token 是 case 或 default, 它標記其後的語句,
+  // follows in the innermost switch. The label is a jump target, so nothing // 屬於最內層的 switch. 標籤是跳躍目標,
+  // before it fuses with what comes after. // 所以之前的指令不會與其後的融合
+  else if (tk == Case || tk == Default) {
+    if (!swb) { printf("%d: case outside switch\n", line); exit(-1); }
+    if (tk == Case) {
+      // Parse the value, then drop its code and record it with the address. // 解析值, 然後丟棄其程式碼並與位址一起記錄
+      next();
+      a = e; expr(Cond);
+      if (swp >= swlim) { printf("%d: too many cases\n", line); exit(-1); }
+      if (!cfold(a)) { printf("%d: bad case value\n", line); exit(-1); }
+      *swp++ = e[0]; e = a; *swp++ = (int)(e + 1);
+    }
+    else {
+      next();
+      if (swd) { printf("%d: duplicate default\n", line); exit(-1); }
+      swd = e + 1;
+    }
+    if (tk == ':') next(); else { printf("%d: colon expected\n", line); exit(-1); }
+    li = tcall = 0;
+    if (tk != '}') stmt();
+  }
+  // If current token is `break`, jump past the innermost loop or switch. // 如果當前 token 是 break, 跳到最內層的迴圈或 switch 之後
+  // The jump's operand links to the previous `break`'s until it ends. // 跳轉的運算元在其結束之前鏈結到前一個 break 的
+  else if (tk == Break) {
+    // Read token. // 讀取 token
+    next();
+    if (!nbrk) { printf("%d: break outside loop or switch\n", line); exit(-1); }
+    *++e = JMP; *++e = (int)brks; brks = e;
+    if (tk == ';') next(); else { printf("%d: semicolon expected\n", line); exit(-1); }
   }
   // If current token is `return`. // 如果當前 token 是 return
   else if (tk == Return) {
@@ -886,6 +1628,13 @@ void stmt()
     // Parse return expression. // 解析回傳值運算式
     if (tk != ';') expr(Assign);
 
+    // If the value is a function call's, make it a tail call, provided its // 如果回傳值來自函數呼叫, 把它變成尾呼叫,
+    // arguments fit where this function's `loc - 1` parameters are. // 前提是其參數放得進此函數的 `loc - 1` 個參數的位置
+    if (tcall == e && !laddr) {
+      if (e[-1] == ADJ) { if (*e < loc) e[-3] = TJSR; }
+      else e[-1] = TJSR;
+    }
+
     // Add `LEV` instruction to leave the function. // 插入 LEV 指令表示離開函式 (return)
     *++e = LEV;
 
@@ -919,70 +1668,1653 @@ void stmt()
   }
 }
 
-int main(int argc, char **argv)
+// Peephole optimizer for `-O`. // `-O` 使用的窺孔最佳化器
+// Runs over each function's code once it has been generated and rewrites // 在每個函數的程式碼產生後執行, 只用現有的操作碼
+// it in place using only the existing opcodes: constant subexpressions are // 就地改寫程式碼: 常數子運算式被摺疊,
+// folded, multiplies by powers of two become `SHL`, no-op sequences are // 乘以 2 的次方變成 `SHL`, 無作用的指令序列被移除,
+// dropped, and jumps are redirected to the compacted code afterwards. // 之後再把跳轉指令導向壓縮後的程式碼
+
+#if defined(__GNUC__)
+__thread
+#endif
+int **pmap,  // new address of each old instruction // 每個舊指令的新位址
+    **pins;  // start of each output instruction // 每個輸出指令的起始位址
+#if defined(__GNUC__)
+__thread
+#endif
+char *ptgt,  // jump target flag of each old word // 每個舊字組是否為跳躍目標
+     *pjt;   // jump target flag of each output instruction // 每個輸出指令是否為跳躍目標
+
+// Optimize the function whose code runs from `b` (its `ENT`) to `e`. // 最佳化從 `b` (其 `ENT`) 到 `e` 的函數程式碼
+void peep(int *b)
 {
-  int fd, bt, ty, poolsz, *idmain;
-  int *pc, *sp, *bp, a, cycle; // vm registers // 虛擬機暫存器
-  int i, *t; // temps // 暫存變數
+  int *r, *w, n, i, c, k;
+
+  // Mark the jump targets inside the function. // 標記函數內的跳躍目標
+  memset(ptgt, 0, e - b + 1);
+  r = b;
+  while (r <= e) {
+    i = *r++;
+    if (i <= BGE) { if (isjmp(i) && (int *)*r >= b && (int *)*r <= e) ptgt[(int *)*r - b] = 1; ++r; }
+  }
 
-  // Decrement `argc` to get the number of command line arguments. // 遞減 `argc` 取得參數數量
-  // Increment `argv` to point to the first command line argument. // 遞增 `argv` 指向第一個參數
-  --argc; ++argv;
+  // Copy the instructions one at a time and rewrite the tail of the output // 逐一複製指令, 並在輸出的尾端符合樣式時改寫它
+  // while a pattern matches. The output never overtakes the input. Only // 輸出永遠不會超過輸入
+  // the first instruction of a pattern may be a jump target, and a pattern // 只有樣式的第一個指令可以是跳躍目標,
+  // that is dropped as a whole must not contain one. // 而整個被移除的樣式不能包含跳躍目標
+  r = w = b; n = 0;
+  while (r <= e) {
+    pmap[r - b] = w; pjt[n] = ptgt[r - b]; pins[n++] = w;
+    i = *w++ = *r++;
+    if (i <= BGE) { pmap[r - b] = w - 1; *w++ = *r++; }
+
+    k = 1;
+    while (k) {
+      k = 0; i = *pins[n - 1];
+
+      // `IMM a; PSH; IMM b; <op>` => `IMM (a op b)` // `IMM a; PSH; IMM b; <op>` => `IMM (a op b)`
+      if (n >= 4 && *pins[n - 4] == IMM && *pins[n - 3] == PSH && *pins[n - 2] == IMM && i >= OR && i <= MOD &&
+          !pjt[n - 3] && !pjt[n - 2] && !pjt[n - 1] && (i < DIV || pins[n - 2][1])) {
+        pins[n - 4][1] = fold(i, pins[n - 4][1], pins[n - 2][1]);
+        w = pins[n - 4] + 2; n = n - 3; k = 1;
+      }
+      // `IMM -1; PSH; <load>; MUL` (`-x`) => `IMM 0; PSH; <load>; SUB` // `IMM -1; PSH; <load>; MUL` (`-x`) => `IMM 0; PSH; <load>; SUB`
+      else if (n >= 4 && *pins[n - 4] == IMM && pins[n - 4][1] == -1 && *pins[n - 3] == PSH && i == MUL &&
+          (*pins[n - 2] == LLI || *pins[n - 2] == LGI) && !pjt[n - 3] && !pjt[n - 2] && !pjt[n - 1]) {
+        pins[n - 4][1] = 0; *pins[n - 1] = SUB;
+      }
+      // `IMM a; ADDI b` => `IMM (a + b)`, `ADDI a; ADDI b` => `ADDI (a + b)` // `IMM a; ADDI b` => `IMM (a + b)`, `ADDI a; ADDI b` => `ADDI (a + b)`
+      else if (n >= 2 && (*pins[n - 2] == IMM || *pins[n - 2] == ADDI) && i == ADDI && !pjt[n - 1]) {
+        pins[n - 2][1] = pins[n - 2][1] + pins[n - 1][1];
+        w = pins[n - 2] + 2; n = n - 1; k = 1;
+      }
+      // `ADDI 0` and `ADJ 0` do nothing. // `ADDI 0` 和 `ADJ 0` 沒有作用
+      else if ((i == ADDI || i == ADJ) && pins[n - 1][1] == 0 && !pjt[n - 1]) {
+        w = pins[n - 1]; n = n - 1; k = 1;
+      }
+      // `PSH; IMM c; <op>` with a constant right operand. // 右運算元為常數的 `PSH; IMM c; <op>`
+      else if (n >= 3 && *pins[n - 3] == PSH && *pins[n - 2] == IMM && i >= OR && i <= MOD && !pjt[n - 2] && !pjt[n - 1]) {
+        c = pins[n - 2][1];
+        // `+ 0`, `- 0`, `| 0`, `^ 0`, `<< 0`, `>> 0`, `* 1` and `/ 1` do nothing. // 這些運算沒有作用
+        if (!pjt[n - 3] && ((c == 0 && (i == ADD || i == SUB || i == OR || i == XOR || i == SHL || i == SHR)) ||
+            (c == 1 && (i == MUL || i == DIV)))) {
+          w = pins[n - 3]; n = n - 3; k = 1;
+        }
+        // `PSH; IMM c; ADD` => `ADDI c`, `PSH; IMM c; SUB` => `ADDI -c` // `PSH; IMM c; ADD` => `ADDI c`, `PSH; IMM c; SUB` => `ADDI -c`
+        else if (i == ADD || i == SUB) {
+          *pins[n - 3] = ADDI; pins[n - 3][1] = (i == ADD) ? c : -c;
+          w = pins[n - 3] + 2; n = n - 2; k = 1;
+        }
+        // `PSH; IMM 2^k; MUL` => `PSH; IMM k; SHL` // `PSH; IMM 2^k; MUL` => `PSH; IMM k; SHL`
+        else if (i == MUL && c > 1 && (c & (c - 1)) == 0) {
+          i = 0; while (c > 1) { c = c >> 1; ++i; }
+          pins[n - 2][1] = i; *pins[n - 1] = SHL;
+        }
+      }
+    }
+  }
 
-  // If command line argument `-s` is given, // 若指定 `-s` 參數
-  // turn on switch for printing source code line and corresponding // 開啟印出原始碼與對應指令的開關
-  // instructions. // 印出對應的虛擬機指令
-  if (argc > 0 && **argv == '-' && (*argv)[1] == 's') { src = 1; --argc; ++argv; }
+  // Redirect jumps inside the function to the new addresses. // 將函數內的跳轉導向新位址
+  k = 0;
+  while (k < n) {
+    r = pins[k++];
+    if (isjmp(*r) && (int *)r[1] >= b && (int *)r[1] <= e) r[1] = (int)pmap[(int *)r[1] - b];
+  }
 
-  // If command line argument `-d` is given, // 若指定 `-d` 參數
-  // turn on debug switch. // 開啟除錯模式
-  if (argc > 0 && **argv == '-' && (*argv)[1] == 'd') { debug = 1; --argc; ++argv; }
+  // Move the function's lines in `lnt` too. Folding can move a line's // 也移動 `lnt` 中此函數的行
+  // start past the next one's, so keep the starts in order. // 摺疊可能使某行的起始超過下一行的, 所以保持起始位置的順序
+  r = lnp;
+  while (r > lnt && r[-2] >= b - text) {
+    r = r - 2; *r = pmap[*r - (b - text)] - text;
+    if (r + 2 < lnp && r[2] < *r) *r = r[2];
+  }
+  if (lmark >= b) lmark = (lmark < e) ? pmap[lmark + 1 - b] - 1 : w - 1;
 
-  // If source code file path is not given, print program usage and exit // 若沒指定原始碼檔案，印出使用方式後結束
-  // program. // 結束程式
-  if (argc < 1) { printf("usage: c4 [-s] [-d] file ...\n"); return -1; }
+  // Clear the freed words and move the end of code back. // 清除釋放的字組並將程式碼結尾往回移
+  memset(w, 0, (e + 1 - w) * sizeof(int));
+  e = w - 1;
+  if (le > e) le = e;
+}
 
-  // Open source code file. // 開啟原始碼檔案
-  // If failed, print error and exit program. // 若失敗則印出錯誤訊息並結束
-  if ((fd = open(*argv, 0)) < 0) { printf("could not open(%s)\n", *argv); return -1; }
+// Inliner for `-O`. // `-O` 使用的內嵌展開器
+// Runs once the whole program is compiled and replaces each `JSR` to a // 在整個程式編譯完後執行, 將每個對小型葉函數
+// small leaf function (one that calls nothing) with a copy of its code. // (不呼叫其他函數的函數) 的 `JSR` 換成其程式碼的複本
+// The arguments are already on the stack where the callee's frame would // 參數已經在堆疊上被呼叫者框架的上方,
+// sit above them, so the copy's `LEA`, `LLI` and `SLI` offsets are moved // 所以複本的 `LEA`, `LLI` 和 `SLI` 位移被移到呼叫者的框架中,
+// into the caller's frame, below the caller's stack depth at the call. // 位於呼叫者在呼叫處的堆疊深度之下
+// The callee's locals get room with `ADJ`, and its `LEV`s jump past the copy. // 被呼叫者的區域變數以 `ADJ` 取得空間, 其 `LEV` 跳過複本
+
+enum { Ibud = 32 }; // largest function inlined, in words // 內嵌展開的最大函數, 以字組計
+
+#if defined(__GNUC__)
+__thread
+#endif
+int *itext,  // copy of the code before inlining // 內嵌展開之前的程式碼複本
+    *idep,   // stack depth at each jump target of the copy // 複本中每個跳躍目標的堆疊深度
+    *ifix,   // caller jumps whose old targets still need moving // 舊目標仍需移動的呼叫者跳轉
+    *iloc,   // new address of each word of the function being inlined // 正在內嵌展開的函數中每個字組的新位址
+    iend,    // last word of the copy // 複本的最後一個字組
+    iarg;    // largest argument offset the function uses // 函數使用的最大參數位移
+#if defined(__GNUC__)
+__thread
+#endif
+int **imap;  // new address of each word of the copy // 複本中每個字組的新位址
+
+// If the function at `f` in the copy can be inlined, return its last // 如果複本中位於 `f` 的函數可以內嵌展開, 回傳其最後的 `LEV`,
+// `LEV` and set `iarg`, else return 0. // 並設定 `iarg`, 否則回傳 0
+int *inlend(int *f)
+{
+  int *t, *q, i;
+
+  if (f <= itext || f > itext + iend || *f != ENT) return 0;
+  t = f + 2; q = 0; iarg = 1;
+  while (t <= itext + iend && *t != ENT) {
+    i = *t;
+    if (i == JSR || i == TJSR || t - f >= Ibud) return 0;
+    if ((i == LEA || i == LLI || i == SLI) && t[1] > iarg) iarg = t[1];
+    q = t;
+    t = t + (i <= BGE ? 2 : 1);
+  }
+  return (q && *q == LEV) ? q : 0;
+}
 
-  // Set buffer size. // 設定緩衝區大小
-  poolsz = 256*1024; // arbitrary size // 任意指定的大小
+// Inline the calls in `text[1]` .. `e[0]` and move everything that points // 內嵌展開 `text[1]` .. `e[0]` 中的呼叫,
+// into the code: jumps, functions' symbols and the line table. // 並移動所有指向程式碼的東西: 跳轉、函數的符號和行表
+void inl()
+{
+  int *r, *f, *q, *t, *fp, i, x, d, n, k, reach;
+
+  // Work from a copy of the code and write the result over the original. // 從程式碼的複本進行, 並將結果寫回原處
+  iend = e - text;
+  r = itext; t = text; while (t <= e) *r++ = *t++;
+  r = itext + 1; e = text; fp = ifix; d = k = 0; reach = 0;
+  while (r <= itext + iend) {
+    i = *r;
+
+    // Track the stack depth; below a jump it comes from the jump. // 追蹤堆疊深度; 跳轉之後的深度來自跳轉
+    if (i == ENT) d = r[1]; else if (!reach) d = idep[r - itext];
+    imap[r - itext] = imap[r + 1 - itext] = e + 1;
+    reach = 1;
+
+    f = (i == JSR) ? itext + ((int *)r[1] - text) : 0;
+    n = (i == JSR && r[2] == ADJ) ? r[3] : 0;
+    if (f && (q = inlend(f)) && iarg <= n + 1 && e + Ibud * 2 + 8 < tlim) {
+      // Find where each instruction of the callee goes. // 找出被呼叫者每個指令的位置
+      x = (int)(e + 1 + (f[1] ? 2 : 0)); t = f + 2;
+      while (t <= q) {
+        iloc[t - f] = x;
+        x = x + (*t == LEV ? (t < q ? 2 : 0) : (*t <= BGE ? 2 : 1)) * sizeof(int);
+        t = t + (*t <= BGE ? 2 : 1);
+      }
 
-  // Allocate symbol table. // 配置符號表
-  // If failed, print error and exit program. // 若失敗則印出錯誤訊息並結束
-  if (!(sym = malloc(poolsz))) { printf("could not malloc(%d) symbol area\n", poolsz); return -1; }
+      // Copy it. // 複製它
+      if (f[1]) { *++e = ADJ; *++e = -f[1]; }
+      t = f + 2;
+      while (t < q) {
+        i = *t++;
+        if (i == LEV) { *++e = JMP; *++e = iloc[q - f]; }
+        else {
+          *++e = i;
+          if (i <= BGE) {
+            x = *t++;
+            if (i == LEA || i == LLI || i == SLI) x = (x > 0) ? x - 2 - d : x - d;
+            else if (isjmp(i)) x = iloc[(int *)x - text - (f - itext)];
+            *++e = x;
+          }
+        }
+      }
+      if (f[1]) { *++e = ADJ; *++e = f[1]; }
+      r = r + 2;
+    }
+    else {
+      *++e = *r++;
+      if (i <= BGE) {
+        x = *++e = *r++;
+        if (isjmp(i)) *fp++ = (int)e;
+        if (i == ADJ) d = d - x;
+      }
+      if (i == PSH) ++d;
+      else if ((i >= OR && i <= MOD) || i == SI || i == SC || (i >= BEQ && i <= BGE)) --d;
+      if (isjmp(i) && i != JSR && i != TJSR) idep[(int *)x - text] = d;
+      // The `JMP`s of a jump table are all reached from its `JTAB`. // 跳躍表的 `JMP` 都由其 `JTAB` 到達
+      if (i == JTAB) k = x + 1;
+      else if (i == JMP && k) --k;
+      else if (i == JMP || i == LEV) reach = 0;
+    }
+  }
 
-  // Allocate instruction buffer. // 配置指令區
-  // If failed, print error and exit program. // 若失敗則印出錯誤訊息並結束
-  if (!(le = e = malloc(poolsz))) { printf("could not malloc(%d) text area\n", poolsz); return -1; }
+  // Move the callers' jumps to the new code. // 將呼叫者的跳轉移到新的程式碼
+  while (fp > ifix) { t = (int *)*--fp; *t = (int)imap[(int *)*t - text]; }
 
-  // Allocate data buffer. // 配置資料區
-  // If failed, print error and exit program. // 若失敗則印出錯誤訊息並結束
-  if (!(data = malloc(poolsz))) { printf("could not malloc(%d) data area\n", poolsz); return -1; }
+  // Move the functions and the line table. // 移動函數和行表
+  t = sym;
+  while (t < symend) { if (t[Class] == Fun) t[Val] = (int)imap[(int *)t[Val] - text]; t = t + Idsz; }
+  t = lnt;
+  while (t < lnp) { *t = imap[*t] - text; t = t + 2; }
+  le = lmark = e;
+}
 
-  // Allocate stack. // 配置堆疊區
-  // If failed, print error and exit program. // 若失敗則印出錯誤訊息並結束
-  if (!(sp = malloc(poolsz))) { printf("could not malloc(%d) stack area\n", poolsz); return -1; }
+// Guest output. // 客體程式的輸出
+// A guest's `printf` formats into a buffer of `osz` bytes, which is written // 客體程式的 `printf` 格式化到 `osz` 位元組的緩衝區,
+// to fd 1 when it fills, before the guest reads or writes a file, and // 緩衝區滿時、客體程式讀寫檔案之前,
+// before the VM prints anything of its own, such as the `exit(...)` line. // 以及虛擬機自己印出任何東西 (例如 `exit(...)` 行) 之前, 寫到 fd 1
 
-  // Clear the buffers. // 清空所有緩衝區
-  memset(sym,  0, poolsz);
-  memset(e,    0, poolsz);
-  memset(data, 0, poolsz);
+// Formatting flags. // 格式化旗標
+enum { Fleft = 1, Fzero = 2, Fplus = 4, Fspace = 8 };
 
-  // Keywords and system call names. // 關鍵字與系統呼叫名稱
-  p = "char else enum if int return sizeof while "
-      "open read close printf malloc free memset memcmp exit void main";
+enum { Onum = 64 }; // room for the digits of a number, past the buffer // 緩衝區之後存放數字各位數的空間
 
-  // For each keyword from `char` to `while`, // 對每個關鍵字從 `char` 到 `while`
-  // call `next` to create symbol table entry, // 呼叫 `next` 建立符號表項目
-  // store the keyword's token type in the symbol table entry's `Tk` field. // 將 token 類型存入 `Tk` 欄位
-  i = Char; while (i <= While) { next(); id[Tk] = i++; } // add keywords to symbol table // 加入關鍵字至符號表
+#if defined(__GNUC__)
+__thread
+#endif
+char *obuf,  // guest output buffer (客體程式的輸出緩衝區)
+     *op,    // end of the buffered output (已緩衝輸出的結尾)
+     *olim;  // buffer limit, followed by `Onum` bytes of scratch (緩衝區上限, 之後接著 `Onum` 位元組的暫存空間)
 
-  // For each system call name from `open` to `exit`, // 對每個系統呼叫從 `open` 到 `exit`
-  // call `next` to create symbol table entry, // 呼叫 `next` 建立符號表項目
-  // set the symbol table entry's symbol type field be `Sys`, // 將類型設為 `Sys`
-  // set the symbol table entry's associated value type field be the system // 將回傳型別設為整數
+// Write out the buffered output. // 寫出已緩衝的輸出
+void oflush()
+{
+  char *b;
+  int n;
+
+#if defined(__GNUC__)
+  // What the host printed so far goes first. // 主機到目前為止印出的內容先寫出
+  fflush(stdout);
+#endif
+  b = obuf;
+  while (b < op && (n = write(1, b, op - b)) > 0) b = b + n;
+  op = obuf;
+}
+
+// Append the `n` bytes at `s`; a run longer than the buffer goes straight // 附加 `s` 處的 `n` 個位元組;
+// out. // 比緩衝區還長的內容直接寫出
+void owr(char *s, int n)
+{
+  int k;
+
+  if (olim - op < n) {
+    oflush();
+    if (olim - op < n) { while (n > 0 && (k = write(1, s, n)) > 0) { s = s + k; n = n - k; } return; }
+  }
+  while (n) { *op++ = *s++; --n; }
+}
+
+// Append `n` copies of `c`. // 附加 `n` 個 `c`
+void opad(int c, int n)
+{
+  while (n > 0) { if (op == olim) oflush(); *op++ = c; --n; }
+}
+
+// Format the guest `printf` call whose `n` arguments, the format first, // 格式化客體程式的 `printf` 呼叫, 其 `n` 個參數 (格式在前)
+// end below `t`. Conversions are `d i u x X o c s p %` with the flags // 結束於 `t` 之下. 轉換有 `d i u x X o c s p %`,
+// `- 0 + space`, a width and a precision, either of which may be `*`. // 旗標有 `- 0 + 空白`, 以及寬度和精確度, 兩者都可以是 `*`
+// As with the host's `printf`, a number is 32 bits unless it has a length // 與主機的 `printf` 一樣, 數字是 32 位元,
+// of `l` or `ll`, 16 with `h` and 8 with `hh`. // 除非長度是 `l` 或 `ll`; `h` 為 16 位元, `hh` 為 8 位元
+// Conversions past the last argument get 0. Return the bytes written. // 超過最後一個參數的轉換得到 0. 回傳寫出的位元組數
+int oprintf(int *t, int n)
+{
+  char *f, *s, *h, *pf;
+  int a, c, x, l, w, pr, fl, z, b, d, neg;
+
+  f = (char *)t[-1]; t = t - 2; --n; a = 0;
+  while (*f) {
+    // Copy the text up to the next `%`. // 複製到下一個 `%` 之前的文字
+    s = f; while (*s && *s != '%') ++s;
+    if (s > f) { owr(f, s - f); a = a + (s - f); f = s; }
+    else {
+      // Flags, width, precision and length. // 旗標、寬度、精確度和長度
+      ++f; fl = 0;
+      while (*f == '-' || *f == '0' || *f == '+' || *f == ' ') {
+        if (*f == '-') fl = fl | Fleft; else if (*f == '0') fl = fl | Fzero; else if (*f == '+') fl = fl | Fplus; else fl = fl | Fspace;
+        ++f;
+      }
+      w = 0;
+      if (*f == '*') { ++f; if (n > 0) { w = *t--; --n; } if (w < 0) { fl = fl | Fleft; w = -w; } }
+      else while (*f >= '0' && *f <= '9') w = w * 10 + *f++ - '0';
+      pr = -1;
+      if (*f == '.') {
+        ++f; pr = 0;
+        if (*f == '*') { ++f; if (n > 0) { pr = *t--; --n; } if (pr < 0) pr = -1; }
+        else while (*f >= '0' && *f <= '9') pr = pr * 10 + *f++ - '0';
+      }
+      // `b` is the number's width in bits. // `b` 是數字的位元寬度
+      b = 32;
+      while (*f == 'l' || *f == 'h' || *f == 'z' || *f == 'j' || *f == 't') { b = (*f == 'h') ? b / 2 : 64; ++f; }
+
+      // The conversion gives the text `h`, `l` bytes long, after the prefix // 轉換得到長度為 `l` 的文字 `h`,
+      // `pf` and `z` zeros. // 前面接著前綴 `pf` 和 `z` 個零
+      c = *f; if (c) ++f;
+      s = "diuxXocsp"; while (*s && *s != c) ++s;
+      x = 0; if (c && *s && n > 0) { x = *t--; --n; }
+      pf = ""; z = 0;
+      if (c == 's' || (c == 'p' && !x)) {
+        if (c == 'p') h = "(nil)"; else if (x) h = (char *)x; else h = "(null)";
+        l = 0; while (h[l] && (pr < 0 || l < pr || c == 'p')) ++l;
+      }
+      else if (c == 'c') { h = olim; *h = x; l = 1; }
+      else if (c == 'd' || c == 'i' || c == 'u' || c == 'x' || c == 'X' || c == 'o' || c == 'p') {
+        if (c == 'p') b = 64;
+        if (b < 64) { d = 1; x = x << (64 - b); x = (c == 'd' || c == 'i') ? x >> (64 - b) : (x >> (64 - b)) & ((d << b) - 1); }
+        b = (c == 'x' || c == 'X' || c == 'p') ? 16 : (c == 'o') ? 8 : 10;
+        neg = (c == 'd' || c == 'i') && x < 0;
+        if (neg) pf = "-"; else if ((c == 'd' || c == 'i') && (fl & Fplus)) pf = "+";
+        else if ((c == 'd' || c == 'i') && (fl & Fspace)) pf = " "; else if (c == 'p') pf = "0x";
+        // Digits from the last; the shifts and halving keep them unsigned. // 從最後一位開始; 位移和減半讓它們保持無號
+        h = olim + Onum; l = 0;
+        while (x) {
+          if (b == 16) { d = x & 15; x = (x >> 4) & 0x0fffffffffffffff; }
+          else if (b == 8) { d = x & 7; x = (x >> 3) & 0x1fffffffffffffff; }
+          else if (neg) { d = -(x % 10); x = x / 10; }
+          else if (x < 0) { d = ((x >> 1) & 0x7fffffffffffffff) / 5; z = x - d * 10; x = d; d = z; }
+          else { d = x % 10; x = x / 10; }
+          *--h = (d < 10) ? '0' + d : (c == 'X' ? 'A' : 'a') + d - 10; ++l;
+        }
+        z = (pr < 0) ? (l ? 0 : 1) : (pr > l ? pr - l : 0);
+        d = 0; while (pf[d]) ++d;
+        if (pr < 0 && (fl & Fzero) && !(fl & Fleft) && w > d + z + l) z = w - d - l;
+      }
+      else if (c == '%') { h = "%"; l = 1; }
+      // Anything else is copied as is. // 其他的原樣複製
+      else { h = olim; h[0] = '%'; h[1] = c; l = c ? 2 : 1; }
+
+      d = 0; while (pf[d]) ++d;
+      x = d + z + l; w = (w > x) ? w - x : 0;
+      if (!(fl & Fleft)) opad(' ', w);
+      owr(pf, d); opad('0', z); owr(h, l);
+      if (fl & Fleft) opad(' ', w);
+      a = a + x + w;
+    }
+  }
+  return a;
+}
+
+// `read` and `write` for guests, in order with the buffered output. // 客體程式的 `read` 和 `write`, 與已緩衝的輸出保持順序
+int oread(int fd, char *b, int n) { oflush(); return read(fd, b, n); }
+int owrite(int fd, char *b, int n) { oflush(); return write(fd, b, n); }
+
+// Most mappings a `--batch` job makes: 9 areas, 2 for `-m`, 9 for `-O`, // `--batch` 工作最多的映射數量: 9 個區域, `-m` 2 個, `-O` 9 個,
+// 7 for `-r`, 5 for `-p` and `-l`, the source file and the `-j` code. // `-r` 7 個, `-p` 和 `-l` 5 個, 原始碼檔案和 `-j` 的程式碼
+// Keep it in step with the `arena` calls in `run`; `amap` stops a job // 要與 `run` 中的 `arena` 呼叫保持一致;
+// that makes more. // `amap` 會停止映射更多的工作
+enum { Amax = 34 };
+
+// Add mapping `m` of `sz` bytes to `alist`, if kept. If the list is full, // 若有保留 `alist`, 將 `sz` 位元組的映射 `m` 加入其中
+// release it and stop with an error rather than write past the list. // 若清單已滿, 釋放該映射並以錯誤停止, 而不寫出清單之外
+void amap(char *m, int sz)
+{
+  if (!alp) return;
+  if (alp >= alend) { munmap(m, sz); printf("too many mappings\n"); exit(-1); }
+  *alp++ = (int)m; *alp++ = sz;
+}
+
+// Reserve `sz` bytes between two guard pages with anonymous mmap. // 以匿名 mmap 在兩個保護頁之間保留 `sz` 位元組
+// Pages are committed, already zeroed, on first touch. // 分頁在第一次存取時才配置, 並且已經清為零
+// The mapping is added to `alist`, if kept. // 若有保留 `alist`, 將映射加入其中
+char *arena(int sz, char *name)
+{
+  char *m;
+
+  sz = (sz + PGSZ - 1) & -PGSZ;
+  m = mmap(0, sz + 2 * PGSZ, 0, MAP_ARENA, -1, 0);
+  if ((int)m == -1 || (int)mmap(m + PGSZ, sz, PROT_RW, MAP_ARENA | MAP_FIXED, -1, 0) == -1) {
+    printf("could not mmap(%d) %s area\n", sz, name); exit(-1);
+  }
+  amap(m, sz + 2 * PGSZ);
+  return m + PGSZ;
+}
+
+// Pooled guest heap for `-m`. // `-m` 使用的客體程式記憶體池
+// Blocks are bumped off an arena of `hsz` bytes, each after a word with // 區塊從 `hsz` 位元組的區域依序切出, 每個區塊之前有一個記錄其大小類別的字組
+// its size class. A freed block goes on its class's free list for the // 被釋放的區塊放到其類別的空閒串列上, 供同類別的下一次配置使用
+// next allocation of that class; classes go up by 8 bytes to `Hsmall`, // 類別以 8 位元組遞增到 `Hsmall`,
+// then double. `mreset` frees every block at once. // 之後加倍. `mreset` 一次釋放所有區塊
+
+enum { Hsmall = 1024, Hcls = 192 }; // largest 8-byte step class, number of classes // 以 8 位元組遞增的最大類別, 類別數量
+
+#if defined(__GNUC__)
+__thread
+#endif
+char *hbase, // heap arena, or 0 to use the host's `malloc` (記憶體池區域, 為 0 時使用主機的 `malloc`)
+     *hp,    // first unused byte of the arena (區域中第一個未使用的位元組)
+     *hlim;  // arena limit (區域上限)
+#if defined(__GNUC__)
+__thread
+#endif
+int **hfl;   // free list of each class, linked through the blocks' first word (每個類別的空閒串列, 以區塊的第一個字組串接)
+
+// Allocate `n` bytes for a guest. Return 0 if the heap is full. // 為客體程式配置 `n` 個位元組. 記憶體池已滿時回傳 0
+char *gmalloc(int n)
+{
+  int c, sz, *b;
+
+  if (!hbase) return malloc(n);
+  // A block larger than the arena can never fit, and sizing its class // 比區域還大的區塊永遠放不下,
+  // could overflow. // 而計算其類別可能會溢位
+  if (n < 0 || n > hlim - hbase) return 0;
+  if (n <= Hsmall) { c = (n + 7) >> 3; if (!c) c = 1; sz = c << 3; }
+  else { c = Hsmall >> 3; sz = Hsmall; while (sz < n) { sz = sz * 2; ++c; } }
+  if ((b = hfl[c])) { hfl[c] = (int *)*b; return (char *)b; }
+  if (hlim - hp < sz + sizeof(int)) return 0;
+  *(int *)hp = c; b = (int *)hp + 1; hp = hp + sz + sizeof(int);
+  return (char *)b;
+}
+
+// Free guest block `p`. // 釋放客體程式的區塊 `p`
+void gfree(char *p)
+{
+  int *b;
+
+  if (!hbase) { free(p); return; }
+  if (!p) return;
+  b = (int *)p; *b = (int)hfl[b[-1]]; hfl[b[-1]] = b;
+}
+
+// `mreset`: free every guest block. Return 0, or -1 without `-m`. // `mreset`: 釋放所有客體程式的區塊. 回傳 0, 沒有 `-m` 時回傳 -1
+int greset()
+{
+  if (!hbase) return -1;
+  hp = hbase; memset(hfl, 0, Hcls * sizeof(int *));
+  return 0;
+}
+
+#if defined(__GNUC__) && defined(__x86_64__)
+// Native code generator for `-j`. // `-j` 使用的原生機器碼產生器
+// Translates the whole text segment, one function (`ENT` ... `LEV`) after // 將整個程式碼段逐一函數 (`ENT` ... `LEV`) 翻譯成 x86-64 機器碼
+// another, into x86-64 code in an mmap'd buffer. VM registers live in host // 放在 mmap 配置的緩衝區中
+// registers: `a` in rax, `sp` in rbx, `bp` in rbp; rcx, r11 and r12 are // 虛擬機暫存器放在主機暫存器: `a` 在 rax, `sp` 在 rbx, `bp` 在 rbp
+// scratch. The VM stack keeps its layout, so `JSR` reserves the return // rcx, r11 和 r12 為暫用暫存器
+// address slot and then does a native `call`, and `LEV` does a native `ret`. // 虛擬機堆疊維持原本的配置, 所以 `JSR` 先保留返回位址欄位再做原生 `call`, `LEV` 則做原生 `ret`
+// c4 itself skips this block (see `next`). // c4 本身會跳過這個區塊 (見 `next`)
+
+__thread char *jc,    // native code cursor // 原生機器碼指標
+              **jfix; // 32-bit branch displacements to patch // 待修補的 32 位元跳躍位移
+__thread int **jtgt,  // bytecode target of each displacement // 每個跳躍位移的位元組碼目標
+             jnfix;   // number of displacements // 跳躍位移的數量
+
+// Emit one byte. // 輸出一個位元組
+void jb(int b) { *jc++ = b; }
+
+// Emit a 32-bit little-endian value. // 輸出一個 32 位元小端序數值
+void jd(int d) { jb(d); jb(d >> 8); jb(d >> 16); jb(d >> 24); }
+
+// Emit a 64-bit little-endian value. // 輸出一個 64 位元小端序數值
+void jq(int q) { jd(q); jd(q >> 32); }
+
+// Emit a branch displacement to bytecode address `t`, patched later. // 輸出跳到位元組碼位址 `t` 的跳躍位移, 稍後修補
+void jrel(int t) { jfix[jnfix] = jc; jtgt[jnfix++] = (int *)t; jd(0); }
+
+// Emit `mov r, [rbx + 8 * n]`, i.e. load VM stack slot `sp[n]`. // 輸出 `mov r, [rbx + 8 * n]`, 也就是載入虛擬機堆疊欄位 `sp[n]`
+// `r` is the host register number (rdi 7, rsi 6, rdx 2, rcx 1, r8 8, r9 9). // `r` 是主機暫存器編號
+void jarg(int r, int n) { jb(r < 8 ? 0x48 : 0x4C); jb(0x8B); jb(0x80 | (r & 7) << 3 | 3); jd(n * 8); }
+
+// Emit a call to host function `f` with the native stack 16-byte aligned. // 輸出對主機函數 `f` 的呼叫, 並將原生堆疊對齊 16 位元組
+// `w` is 1 if `f` returns a 32-bit int that must be sign extended into rax. // 若 `f` 回傳 32 位元整數, 需要符號延伸到 rax, 則 `w` 為 1
+void jcall(void *f, int w)
+{
+  jb(0x49); jb(0x89); jb(0xE4);             // mov r12, rsp
+  jb(0x48); jb(0x83); jb(0xE4); jb(0xF0);   // and rsp, -16
+  jb(0x49); jb(0xBB); jq((int)f);           // mov r11, f
+  jb(0x41); jb(0xFF); jb(0xD3);             // call r11
+  jb(0x4C); jb(0x89); jb(0xE4);             // mov rsp, r12
+  if (w) { jb(0x48); jb(0x63); jb(0xC0); }  // movsxd rax, eax
+}
+
+// `EXIT` system call in native code. // 原生機器碼中的 `EXIT` 系統呼叫
+void jexit(int c) { oflush(); printf("exit(%d)\n", c); exit(c); }
+
+// Stack overflow in native code. // 原生機器碼中的堆疊溢位
+void jover() { oflush(); printf("stack overflow\n"); exit(-1); }
+
+// Release the tables of `jitrun` that fails and its code buffer `buf` of // 釋放失敗的 `jitrun` 的表格和其 `sz` 位元組的程式碼緩衝區 `buf`,
+// `sz` bytes, unless `alist` has it. Return -1. // 除非 `alist` 中已有它. 回傳 -1
+int jdrop(char *buf, int sz, char **map)
+{
+  free(map); free(jfix); free(jtgt); jfix = 0; jtgt = 0;
+  if (!alp) munmap(buf, sz);
+  return -1;
+}
+
+// Compile text segment `text[1]` .. `end[0]` and run it from `entry`. // 編譯程式碼段 `text[1]` .. `end[0]`, 並從 `entry` 開始執行
+// `sp` is the VM stack top, `argc`/`argv` are `main`'s arguments. // `sp` 是虛擬機堆疊頂端, `argc`/`argv` 是 `main` 的參數
+// Return the exit code. // 回傳離開代碼
+int jitrun(int *text, int *end, int *entry, int *sp, int argc, char **argv)
+{
+  char *buf, **map;
+  int *pc, i, n, sz;
+
+  // Size the code buffer for the worst case of about 80 bytes per word. // 以每個字組約 80 位元組的最壞情況估計緩衝區大小
+  sz = (end - text + 1) * 80 + 4096;
+  buf = mmap(0, sz, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (buf == MAP_FAILED) { printf("could not mmap(%d) jit area\n", sz); return -1; }
+  amap(buf, sz);
+
+  // `map[k]` is the native address of the instruction at `text + k`. // `map[k]` 是位於 `text + k` 的指令的原生位址
+  map = malloc((end - text + 1) * sizeof(char *));
+  jfix = malloc((end - text + 1) * sizeof(char *));
+  jtgt = malloc((end - text + 1) * sizeof(int *));
+  if (!map || !jfix || !jtgt) { printf("could not malloc jit tables\n"); return jdrop(buf, sz, map); }
+  jnfix = 0;
+
+  jc = buf;
+
+  // Entry trampoline: `int (*)(int *sp, char *main)`. // 進入跳板: `int (*)(int *sp, char *main)`
+  // Save the callee-saved registers used, load VM `sp` and call `main`. // 保存會用到的被呼叫者保存暫存器, 載入虛擬機 `sp` 並呼叫 `main`
+  jb(0x53); jb(0x55); jb(0x41); jb(0x54);   // push rbx; push rbp; push r12
+  jb(0x48); jb(0x89); jb(0xFB);             // mov rbx, rdi
+  jb(0xFF); jb(0xD6);                       // call rsi
+  jb(0x41); jb(0x5C); jb(0x5D); jb(0x5B);   // pop r12; pop rbp; pop rbx
+  jb(0xC3);                                 // ret
+
+  // Translate each instruction. // 翻譯每個指令
+  pc = text + 1;
+  while (pc <= end) {
+    map[pc - text] = jc;
+    i = *pc++;
+
+    // lea rax, [rbp + 8 * n] // 載入區域變數位址
+    if      (i == LEA) { jb(0x48); jb(0x8D); jb(0x85); jd(*pc++ * 8); }
+    // mov rax, imm64 // 載入立即值
+    else if (i == IMM) { jb(0x48); jb(0xB8); jq(*pc++); }
+    // jmp rel32 // 無條件跳躍
+    else if (i == JMP) { jb(0xE9); jrel(*pc++); }
+    // sub rbx, 8 (return address slot); call rel32 // 保留返回位址欄位後呼叫子程式
+    else if (i == JSR) { jb(0x48); jb(0x83); jb(0xEB); jb(8); jb(0xE8); jrel(*pc++); }
+    // Index the 5-byte `jmp rel32`s that follow with `a`, or take the last: // 以 `a` 索引其後的 5 位元組 `jmp rel32`, 或取最後一個:
+    // mov rcx, rax; mov r11d, n; cmp rcx, r11; cmovae rcx, r11; // 無號比較使負數也超出範圍
+    // lea rcx, [rcx + 4 * rcx]; lea r11, [rip + 6]; add r11, rcx; jmp r11 //
+    else if (i == JTAB) {
+      jb(0x48); jb(0x89); jb(0xC1); jb(0x41); jb(0xBB); jd(*pc++); jb(0x4C); jb(0x39); jb(0xD9);
+      jb(0x49); jb(0x0F); jb(0x43); jb(0xCB); jb(0x48); jb(0x8D); jb(0x0C); jb(0x89);
+      jb(0x4C); jb(0x8D); jb(0x1D); jd(6); jb(0x49); jb(0x01); jb(0xCB); jb(0x41); jb(0xFF); jb(0xE3);
+    }
+    // mov rcx, [rbx + 8 * i]; mov [rbp + 16 + 8 * i], rcx for each argument; // 對每個參數
+    // lea rbx, [rbp + 8]; mov rbp, [rbp]; jmp rel32 // 尾呼叫, 沿用呼叫者的原生返回位址
+    else if (i == TJSR) {
+      n = (pc[1] == ADJ) ? pc[2] : 0;
+      while (n) { --n; jb(0x48); jb(0x8B); jb(0x8B); jd(n * 8); jb(0x48); jb(0x89); jb(0x8D); jd(n * 8 + 16); }
+      jb(0x48); jb(0x8D); jb(0x5D); jb(8); jb(0x48); jb(0x8B); jb(0x6D); jb(0); jb(0xE9); jrel(*pc++);
+    }
+    // test rax, rax; jz/jnz rel32 // 為零/不為零則跳
+    else if (i == BZ || i == BNZ) {
+      jb(0x48); jb(0x85); jb(0xC0); jb(0x0F); jb(i == BZ ? 0x84 : 0x85); jrel(*pc++);
+    }
+    // sub rbx, 8; mov [rbx], rbp; mov rbp, rbx; sub rbx, 8 * n // 進入子程式
+    else if (i == ENT) {
+      jb(0x48); jb(0x83); jb(0xEB); jb(8); jb(0x48); jb(0x89); jb(0x2B);
+      jb(0x48); jb(0x89); jb(0xDD); jb(0x48); jb(0x81); jb(0xEB); jd(*pc++ * 8);
+      // mov rcx, slim; cmp rbx, rcx; jae +23; call jover (23 bytes) // 堆疊溢位檢查
+      jb(0x48); jb(0xB9); jq((int)slim); jb(0x48); jb(0x39); jb(0xCB); jb(0x73); jb(23); jcall(jover, 0);
+    }
+    // add rbx, 8 * n // 調整堆疊
+    else if (i == ADJ) { jb(0x48); jb(0x81); jb(0xC3); jd(*pc++ * 8); }
+    // mov rax, [rbp + 8 * n] // 載入區域整數
+    else if (i == LLI) { jb(0x48); jb(0x8B); jb(0x85); jd(*pc++ * 8); }
+    // mov [rbp + 8 * n], rax // 儲存區域整數
+    else if (i == SLI) { jb(0x48); jb(0x89); jb(0x85); jd(*pc++ * 8); }
+    // mov rax, [x] // 載入全域整數
+    else if (i == LGI) { jb(0x48); jb(0xA1); jq(*pc++); }
+    // mov [x], rax // 儲存全域整數
+    else if (i == SGI) { jb(0x48); jb(0xA3); jq(*pc++); }
+    // add rax, imm32, or mov rcx, imm64; add rax, rcx // 加上立即值
+    else if (i == ADDI) {
+      n = *pc++;
+      if (n == (int)(n << 32 >> 32)) { jb(0x48); jb(0x05); jd(n); }
+      else { jb(0x48); jb(0xB9); jq(n); jb(0x48); jb(0x01); jb(0xC8); }
+    }
+    // mov rcx, [rbx]; add rbx, 8; cmp rcx, rax; jcc rel32 // 比較後條件跳躍
+    else if (i >= BEQ && i <= BGE) {
+      jb(0x48); jb(0x8B); jb(0x0B); jb(0x48); jb(0x83); jb(0xC3); jb(8); jb(0x48); jb(0x39); jb(0xC1); jb(0x0F);
+      jb(i == BEQ ? 0x84 : i == BNE ? 0x85 : i == BLT ? 0x8C : i == BGT ? 0x8F : i == BLE ? 0x8E : 0x8D);
+      jrel(*pc++);
+    }
+    // mov rbx, rbp; mov rbp, [rbx]; add rbx, 16; ret // 離開子程式
+    else if (i == LEV) {
+      jb(0x48); jb(0x89); jb(0xEB); jb(0x48); jb(0x8B); jb(0x2B);
+      jb(0x48); jb(0x83); jb(0xC3); jb(16); jb(0xC3);
+    }
+    // mov rax, [rax] // 載入整數
+    else if (i == LI)  { jb(0x48); jb(0x8B); jb(0x00); }
+    // movsx rax, byte [rax] // 載入字元
+    else if (i == LC)  { jb(0x48); jb(0x0F); jb(0xBE); jb(0x00); }
+    // mov rcx, [rbx]; add rbx, 8; then store int or char // 從堆疊取出位址後儲存整數或字元
+    else if (i == SI || i == SC) {
+      jb(0x48); jb(0x8B); jb(0x0B); jb(0x48); jb(0x83); jb(0xC3); jb(8);
+      // mov [rcx], rax // 儲存整數
+      if (i == SI) { jb(0x48); jb(0x89); jb(0x01); }
+      // mov [rcx], al; movsx rax, al // 儲存字元
+      else { jb(0x88); jb(0x01); jb(0x48); jb(0x0F); jb(0xBE); jb(0xC0); }
+    }
+    // sub rbx, 8; mov [rbx], rax // 推入堆疊
+    else if (i == PSH) { jb(0x48); jb(0x83); jb(0xEB); jb(8); jb(0x48); jb(0x89); jb(0x03); }
+    // Binary operators: rax = [rbx] op rax. // 二元運算: rax = [rbx] op rax
+    else if (i >= OR && i <= MOD) {
+      // mov rcx, rax; mov rax, [rbx]; add rbx, 8 // 右運算元放 rcx, 左運算元從堆疊取出放 rax
+      jb(0x48); jb(0x89); jb(0xC1); jb(0x48); jb(0x8B); jb(0x03); jb(0x48); jb(0x83); jb(0xC3); jb(8);
+      if      (i == OR)  { jb(0x48); jb(0x09); jb(0xC8); }               // or rax, rcx
+      else if (i == XOR) { jb(0x48); jb(0x31); jb(0xC8); }               // xor rax, rcx
+      else if (i == AND) { jb(0x48); jb(0x21); jb(0xC8); }               // and rax, rcx
+      else if (i == ADD) { jb(0x48); jb(0x01); jb(0xC8); }               // add rax, rcx
+      else if (i == SUB) { jb(0x48); jb(0x29); jb(0xC8); }               // sub rax, rcx
+      else if (i == MUL) { jb(0x48); jb(0x0F); jb(0xAF); jb(0xC1); }     // imul rax, rcx
+      else if (i == SHL) { jb(0x48); jb(0xD3); jb(0xE0); }               // shl rax, cl
+      else if (i == SHR) { jb(0x48); jb(0xD3); jb(0xF8); }               // sar rax, cl
+      // cqo; idiv rcx; for `MOD` also mov rax, rdx // 有號除法, `MOD` 取餘數
+      else if (i == DIV || i == MOD) {
+        jb(0x48); jb(0x99); jb(0x48); jb(0xF7); jb(0xF9);
+        if (i == MOD) { jb(0x48); jb(0x89); jb(0xD0); }
+      }
+      // cmp rax, rcx; setcc al; movzx eax, al // 比較並將結果設為 0 或 1
+      else {
+        jb(0x48); jb(0x39); jb(0xC8); jb(0x0F);
+        jb(i == EQ ? 0x94 : i == NE ? 0x95 : i == LT ? 0x9C : i == GT ? 0x9F : i == LE ? 0x9E : 0x9D);
+        jb(0xC0); jb(0x0F); jb(0xB6); jb(0xC0);
+      }
+    }
+    // System calls become direct calls into libc with the arguments loaded // 系統呼叫變成直接呼叫 libc
+    // from the VM stack into argument registers (see the VM loop for the // 參數從虛擬機堆疊載入參數暫存器
+    // stack layout). // (堆疊配置請見虛擬機迴圈)
+    // `open`'s mode is optional, so it also takes the count from `ADJ`. // `open` 的模式是選用的, 所以也從 `ADJ` 取得參數數量
+    else if (i == OPEN) { n = pc[1]; jarg(7, n - 1); jarg(6, n - 2); jarg(2, n - 3); jcall(open, 1); }
+    else if (i == READ) { jarg(7, 2); jarg(6, 1); jarg(2, 0); jcall(oread, 0); }
+    else if (i == CLOS) { jarg(7, 0); jcall(close, 1); }
+    // The following `ADJ` gives the number of arguments, which `oprintf` // 後面的 `ADJ` 提供參數數量,
+    // takes with their end: lea rdi, [rbx + 8 * n]; mov esi, n // `oprintf` 連同參數的結尾一起取得
+    else if (i == PRTF) {
+      n = pc[1];
+      jb(0x48); jb(0x8D); jb(0xBB); jd(n * 8); jb(0xBE); jd(n); jcall(oprintf, 0);
+    }
+    else if (i == MALC) { jarg(7, 0); jcall(gmalloc, 0); }
+    else if (i == FREE) { jarg(7, 0); jcall(gfree, 0); }
+    else if (i == MSET) { jarg(7, 2); jarg(6, 1); jarg(2, 0); jcall(memset, 0); }
+    else if (i == MCMP) { jarg(7, 2); jarg(6, 1); jarg(2, 0); jcall(memcmp, 1); }
+    else if (i == MCPY) { jarg(7, 2); jarg(6, 1); jarg(2, 0); jcall(memcpy, 0); }
+    else if (i == MCHR) { jarg(7, 2); jarg(6, 1); jarg(2, 0); jcall(memchr, 0); }
+    else if (i == SLEN) { jarg(7, 0); jcall(strlen, 0); }
+    else if (i == SCMP) { jarg(7, 1); jarg(6, 0); jcall(strcmp, 1); }
+    else if (i == SCHR) { jarg(7, 1); jarg(6, 0); jcall(strchr, 0); }
+    else if (i == MMAP) { jarg(7, 5); jarg(6, 4); jarg(2, 3); jarg(1, 2); jarg(8, 1); jarg(9, 0); jcall(mmap, 0); }
+    else if (i == LSEK) { jarg(7, 2); jarg(6, 1); jarg(2, 0); jcall(lseek, 0); }
+    else if (i == MUNM) { jarg(7, 1); jarg(6, 0); jcall(munmap, 1); }
+    else if (i == FSTA) { jarg(7, 1); jarg(6, 0); jcall(fstat, 1); }
+    else if (i == MRST) jcall(greset, 0);
+    else if (i == WRIT) { jarg(7, 2); jarg(6, 1); jarg(2, 0); jcall(owrite, 0); }
+    else if (i == EXIT) { jarg(7, 0); jcall(jexit, 0); }
+    // Current instruction is unknown, print error and exit program. // 不明指令，印出錯誤並結束
+    else { printf("jit: unknown instruction = %d\n", i); return jdrop(buf, sz, map); }
+  }
+
+  // Patch branch displacements now that every target has an address. // 所有目標都有位址後, 修補跳躍位移
+  while (jnfix) {
+    --jnfix; jc = jfix[jnfix]; jd(map[jtgt[jnfix] - text] - (jc + 4));
+  }
+
+  // Make the buffer executable instead of writable. // 將緩衝區由可寫改為可執行
+  if (mprotect(buf, sz, PROT_READ | PROT_EXEC)) { printf("could not mprotect jit area\n"); return jdrop(buf, sz, map); }
+
+  // Push `main`'s arguments and the return address slot like `JSR` does, // 像 `JSR` 一樣推入 `main` 的參數和返回位址欄位
+  // then enter through the trampoline. // 然後經由跳板進入
+  *--sp = argc; *--sp = (int)argv; *--sp = 0;
+  jc = map[entry - text]; free(map); free(jfix); free(jtgt);
+  i = ((int (*)(int *, char *))buf)(sp, jc);
+  oflush(); printf("exit(%d)\n", i);
+  return i;
+}
+#else
+// No native code generator for this host (or for c4 itself). // 此主機 (或 c4 本身) 沒有原生機器碼產生器
+int jitrun(int *text, int *end, int *entry, int *sp, int argc, char **argv)
+{
+  printf("-j is only supported on x86-64 hosts\n"); return -1;
+}
+#endif
+
+// Register VM for `-r`. // `-r` 使用的暫存器虛擬機
+// The stack code of each function is translated into three-address code // 每個函數的堆疊碼被翻譯成三位址碼,
+// whose operands are frame slots, i.e. word offsets from `bp`: locals and // 其運算元是框架欄位, 也就是相對於 `bp` 的字組位移:
+// parameters keep their slots, and the value the stack code would push at // 區域變數和參數保留原本的欄位, 堆疊碼在深度 `i` 推入的值
+// depth `i` lives in the slot it would have been pushed to, `T(i)`, just // 放在它原本會被推入的欄位 `T(i)`, 也就是區域變數的正下方
+// below the locals. So a call finds its arguments where `JSR` expects them // 所以呼叫時參數就在 `JSR` 預期的位置,
+// and the frames are laid out as before, but `sp` is never updated at run // 框架配置與之前相同, 但執行時不需要更新 `sp`
+// time. While translating, `vk`/`vv` and `ak`/`av` describe each pushed // 翻譯時, `vk`/`vv` 和 `ak`/`av` 描述每個推入的值和 `a`:
+// value and `a`: a constant, a local's address, a slot, or the `a` register // 常數、區域變數的位址、欄位, 或是 `a` 暫存器 (呼叫的結果)
+// (the result of a call). Constants, addresses and locals are only copied // 常數、位址和區域變數只有在需要時才複製到欄位,
+// into slots when needed, so `x = y + 1` is a single `ADDK x, y, 1`. At // 所以 `x = y + 1` 只是一個 `ADDK x, y, 1`
+// branches, every pushed value is put in its own slot and `a`, if the // 在分支處, 每個推入的值都放進自己的欄位, 而 `a` (若目標會讀取它) 放在 `T(depth)`,
+// target reads it, in `T(depth)`, so all paths meet in the same state. // 所以所有路徑在相同的狀態會合
+
+// register opcodes (暫存器操作碼)
+// `MOV d, x`: `d = x`, `MOVK d, k`: `d = k`, `LEA d, k`: `d = &bp[k]`, `GETA d`: `d = a`. // `d`, `x`, `y` 是欄位, `k` 是常數
+// `LI d, x`: `d = *(int *)x`, `LC d, x`: `d = *(char *)x`, `LGI d, g`: `d = *(int *)g`. //
+// `SI x, y`: `*(int *)x = y`, `SC d, x, y`: `d = *(char *)x = y`, `SGI g, y`: `*(int *)g = y`. //
+// `OR d, x, y` .. `MOD d, x, y`: `d = x op y`, `ORK d, x, k` .. `MODK d, x, k`: `d = x op k`. //
+// `JMP t`, `JZ x, t`, `JNZ x, t`, `JEQ x, y, t` .. `JGE x, y, t`, `JEQK x, k, t` .. `JGEK x, k, t`: // 跳到 `t`
+// branch to `t`. `JTAB x, n, t0 .. tn`: branch to `t(x)`, or `tn` if `x` is not in 0 .. n - 1. // 跳到 `t(x)`, 若 `x` 不在 0 .. n - 1 之間則跳到 `tn`
+// `CALL n, t`: call `t` with `sp` at `bp - n`, `TCALL n, k, t`: tail call `t` with // 以 `bp - n` 為 `sp` 呼叫 `t`, 以位於 `bp - n` 的 `k` 個參數尾呼叫 `t`,
+// the `k` arguments at `bp - n`, `ENT n`: enter with an `n` word frame, // 以 `n` 個字組的框架進入
+// `RET x`: return `x`, `LEV`: return `a`, `SYS i, n, k`: system call `i` with `sp` // 回傳 `x`, 回傳 `a`, 以 `bp - n` 為 `sp` 執行系統呼叫 `i`,
+// at `bp - n` and `k` arguments, `HALT`: exit with `a`. // 有 `k` 個參數, 以 `a` 結束
+enum { RMOV ,RMOVK,RLEA ,RGETA,RLI  ,RLC  ,RLGI ,RSI  ,RSC  ,RSGI ,
+       ROR  ,RXOR ,RAND ,REQ  ,RNE  ,RLT  ,RGT  ,RLE  ,RGE  ,RSHL ,RSHR ,RADD ,RSUB ,RMUL ,RDIV ,RMOD ,
+       RORK ,RXORK,RANDK,REQK ,RNEK ,RLTK ,RGTK ,RLEK ,RGEK ,RSHLK,RSHRK,RADDK,RSUBK,RMULK,RDIVK,RMODK,
+       RJMP ,RJZ  ,RJNZ ,RJEQ ,RJNE ,RJLT ,RJGT ,RJLE ,RJGE ,RJEQK,RJNEK,RJLTK,RJGTK,RJLEK,RJGEK,RJTAB,
+       RCALL,RTCALL,RENT ,RRET ,RLEV ,RSYS ,RHALT };
+
+// kinds of translated values: constant, local address, slot, `a` register (翻譯中的值的種類: 常數、區域變數位址、欄位、`a` 暫存器)
+enum { VK, VL, VS, VA };
+
+#if defined(__GNUC__)
+__thread
+#endif
+int *rtext,  // register code (暫存器碼)
+    *re,     // last register code word emitted (最後輸出的暫存器碼字組)
+    *rlim,   // register code area limit (暫存器碼區上限)
+    *rhalt,  // `HALT` that `main` returns to (`main` 返回到的 `HALT`)
+    *rdst,   // destination operand of the last value computed into `T(vd)` (最後一個計算到 `T(vd)` 的值的目的運算元)
+    *rend,   // `re` right after that instruction, or 0 (該指令之後的 `re`, 或 0)
+    **rmap,  // register code address of each stack code word (每個堆疊碼字組的暫存器碼位址)
+    *rfix,   // (operand, stack code target) of each branch to patch (每個待修補分支的 (運算元, 堆疊碼目標))
+    *rfp,    // end of `rfix` (`rfix` 的結尾)
+    *rdep,   // virtual stack depth at each branch target (每個分支目標的虛擬堆疊深度)
+    *vk,     // kind of each pushed value (每個推入的值的種類)
+    *vv,     // value, address offset or slot of each pushed value (每個推入的值的數值、位址位移或欄位)
+    vd,      // virtual stack depth (虛擬堆疊深度)
+    ak, av,  // kind and value of `a` (`a` 的種類和數值)
+    rloc,    // locals of the function being translated (翻譯中函數的區域變數數量)
+    rmax;    // deepest virtual stack of the function (函數的最大虛擬堆疊深度)
+#if defined(__GNUC__)
+__thread
+#endif
+char *rlab;  // branch target flag of each stack code word (每個堆疊碼字組是否為分支目標)
+
+// Frame slot of the value pushed at depth `i`. // 在深度 `i` 推入的值的框架欄位
+int tslot(int i) { return -(rloc + 1 + i); }
+
+// Return nonzero if the stack code at `t` may read `a` before setting it. // 若位於 `t` 的堆疊碼可能在設定 `a` 之前讀取它則回傳非零
+int alive(int *t) { return !(*t == IMM || *t == LEA || *t == LLI || *t == LGI); }
+
+// Emit register instruction `op` with its first `n` operands of `x`, `y`, `z`. // 輸出暫存器指令 `op` 及 `x`, `y`, `z` 中的前 `n` 個運算元
+void rop(int n, int op, int x, int y, int z)
+{
+  if (re > rlim) { printf("register code area full\n"); exit(-1); }
+  *++re = op;
+  if (n > 0) *++re = x;
+  if (n > 1) *++re = y;
+  if (n > 2) *++re = z;
+}
+
+// Emit branch `op` to stack code address `t`, whose operand is patched when // 輸出跳到堆疊碼位址 `t` 的分支 `op`,
+// all the code is translated. // 其運算元在所有程式碼翻譯完後修補
+void rbr(int op, int x, int y, int *t)
+{
+  rdep[t - text] = vd;
+  rop(op == RJMP ? 0 : op <= RJNZ ? 1 : 2, op, x, y, 0);
+  *++re = 0; *rfp++ = (int)re; *rfp++ = (int)t;
+}
+
+// Copy the value of kind `k` and value `v` to slot `d`. // 將種類為 `k`, 數值為 `v` 的值複製到欄位 `d`
+void rput(int d, int k, int v)
+{
+  if (k == VK) rop(2, RMOVK, d, v, 0);
+  else if (k == VL) rop(2, RLEA, d, v, 0);
+  else if (k == VA) rop(1, RGETA, d, 0, 0);
+  else if (v != d) rop(2, RMOV, d, v, 0);
+}
+
+// Emit `op` computing `a` from `y` and `z` into the free slot `T(vd)`. // 輸出從 `y` 和 `z` 計算 `a` 到空閒欄位 `T(vd)` 的 `op`
+void rval(int n, int op, int y, int z)
+{
+  rop(n, op, tslot(vd), y, z); ak = VS; av = tslot(vd); rdst = re - n + 1; rend = re;
+}
+
+// Return a slot holding `a`, using the free slot `T(vd)` if needed. // 回傳存放 `a` 的欄位, 需要時使用空閒的欄位 `T(vd)`
+int aslot()
+{
+  if (ak != VS) { rput(tslot(vd), ak, av); ak = VS; av = tslot(vd); }
+  return av;
+}
+
+// Put the value pushed at depth `i` in its own slot. // 將在深度 `i` 推入的值放進自己的欄位
+void vmat(int i)
+{
+  rput(tslot(i), vk[i], vv[i]); vk[i] = VS; vv[i] = tslot(i);
+}
+
+// Before local slot `x`, or any local if `x` is 0, is written, put the // 在寫入區域變數欄位 `x` (`x` 為 0 時為任何區域變數) 之前,
+// pushed values still read from it in their own slots. // 將仍從該欄位讀取的推入值放進自己的欄位
+void vflush(int x)
+{
+  int i;
+
+  i = 0;
+  while (i < vd) { if (vk[i] == VS && vv[i] > -(rloc + 1) && (!x || vv[i] == x)) vmat(i); ++i; }
+}
+
+// Inlined code reaches the pushed values, such as its arguments, through // 內嵌展開的程式碼透過框架位移存取推入的值 (例如其參數),
+// frame offsets, so put the one at offset `x`, if any, in its own slot. // 所以將位於位移 `x` 的值 (如果有) 放進自己的欄位
+void vslot(int x)
+{
+  int i;
+
+  i = -x - rloc - 1;
+  if (i >= 0 && i < vd && (vk[i] != VS || vv[i] != x)) vmat(i);
+}
+
+// Store `a` in local slot `x`. If `a` was just computed into `T(vd)`, // 將 `a` 存入區域變數欄位 `x`
+// compute it into `x` instead. // 如果 `a` 剛被計算到 `T(vd)`, 改為直接計算到 `x`
+void rstore(int x)
+{
+  vflush(x);
+  if (ak == VS && re == rend && *rdst == av) { *rdst = x; av = x; rend = 0; }
+  else { rput(x, ak, av); if (ak == VA) { ak = VS; av = x; } }
+}
+
+// Put every pushed value, and `a` if `live`, in its canonical slot. // 將每個推入的值, 以及 `a` (若 `live`), 放進其標準欄位
+void canon(int live)
+{
+  int i;
+
+  i = 0; while (i < vd) vmat(i++);
+  if (live) { rput(tslot(vd), ak, av); ak = VS; av = tslot(vd); }
+}
+
+// Push `a`. A value in a slot that a later push may overwrite is copied. // 推入 `a`. 位於之後的推入可能覆寫的欄位中的值會被複製
+void vpush()
+{
+  if (vd >= ssz / sizeof(int) - 2) { printf("expression too deep\n"); exit(-1); }
+  if (ak == VA || (ak == VS && av <= -(rloc + 1) && av != tslot(vd))) { rput(tslot(vd), ak, av); ak = VS; av = tslot(vd); }
+  vk[vd] = ak; vv[vd] = av; rend = 0;
+  if (++vd > rmax) rmax = vd;
+}
+
+// Pop a pushed value and return a slot holding it. // 彈出一個推入的值並回傳存放它的欄位
+int vpop()
+{
+  --vd;
+  if (vk[vd] != VS) vmat(vd);
+  return vv[vd];
+}
+
+// Translate the stack code `text[1]` .. `end[0]` to register code. // 將堆疊碼 `text[1]` .. `end[0]` 翻譯成暫存器碼
+void rtrans(int *end)
+{
+  int *pc, *f, i, x, y, z, reach;
+
+  // Mark the branch targets. // 標記分支目標
+  pc = text + 1;
+  while (pc <= end) { i = *pc++; if (i <= BGE) { if (isjmp(i)) rlab[(int *)*pc - text] = 1; ++pc; } }
+
+  re = rtext; rfp = rfix; f = 0; reach = 0;
+  pc = text + 1;
+  while (pc <= end) {
+    i = *pc;
+
+    // A function starts with nothing pushed; its frame size is patched // 函數開始時沒有推入任何值;
+    // once its deepest push is known. // 其框架大小在知道最大推入深度後修補
+    if (i == ENT) {
+      if (f) *f = rloc + rmax + 2;
+      rloc = pc[1]; vd = rmax = 0; ak = VA; reach = 1;
+    }
+    // At a branch target, the values are in their canonical slots. // 在分支目標處, 值都在其標準欄位中
+    else if (rlab[pc - text]) {
+      if (reach) canon(alive(pc)); else vd = rdep[pc - text];
+      x = 0; while (x < vd) { vk[x] = VS; vv[x] = tslot(x); ++x; }
+      ak = VS; av = tslot(vd); reach = 1; rend = 0;
+    }
+    rmap[pc - text] = re + 1;
+    ++pc;
+    if (i <= BGE) x = *pc++;
+
+    if      (i == LEA) { vslot(x); ak = VL; av = x; }
+    else if (i == IMM) { ak = VK; av = x; }
+    else if (i == JMP) { canon(alive((int *)x)); rbr(RJMP, 0, 0, (int *)x); reach = 0; }
+    else if (i == JSR) {
+      y = 0; while (y < vd) vmat(y++);
+      rop(1, RCALL, rloc + vd, 0, 0); *++re = 0; *rfp++ = (int)re; *rfp++ = x;
+      ak = VA;
+    }
+    else if (i == TJSR) {
+      y = 0; while (y < vd) vmat(y++);
+      rop(2, RTCALL, rloc + vd, (*pc == ADJ) ? pc[1] : 0, 0); *++re = 0; *rfp++ = (int)re; *rfp++ = x;
+      ak = VA; reach = 0;
+    }
+    // The table's `JMP`s become the list of targets after `JTAB`. // 表格的 `JMP` 變成 `JTAB` 之後的目標列表
+    else if (i == JTAB) {
+      canon(0); rop(2, RJTAB, aslot(), x, 0);
+      while (x-- >= 0) { rdep[(int *)pc[1] - text] = vd; *++re = 0; *rfp++ = (int)re; *rfp++ = pc[1]; pc = pc + 2; }
+      reach = 0;
+    }
+    else if (i == BZ || i == BNZ) {
+      if (alive((int *)x)) canon(1); else canon(0);
+      rbr(i == BZ ? RJZ : RJNZ, aslot(), 0, (int *)x);
+    }
+    else if (i == ENT) { rop(1, RENT, 0, 0, 0); f = re; }
+    // An inlined function's locals are pushed with a negative `ADJ`. // 內嵌展開的函數的區域變數以負的 `ADJ` 推入
+    else if (i == ADJ) {
+      while (x < 0) { vk[vd] = VS; vv[vd] = tslot(vd); ++vd; ++x; }
+      vd = vd - x; if (vd > rmax) rmax = vd;
+    }
+    else if (i == LLI) { vslot(x); ak = VS; av = x; }
+    else if (i == SLI) { vslot(x); rstore(x); }
+    else if (i == LGI) rval(2, RLGI, x, 0);
+    else if (i == SGI) rop(2, RSGI, x, aslot(), 0);
+    else if (i == ADDI) { if (ak == VK) av = av + x; else rval(3, RADDK, aslot(), x); }
+    // The compared value may sit where `a` goes at the target, so move it // 被比較的值可能位於目標處 `a` 要放的欄位,
+    // out of the way first. // 所以先將它移開
+    else if (i >= BEQ && i <= BGE) {
+      if (ak == VK && !alive((int *)x)) { z = vpop(); canon(0); rbr(RJEQK + i - BEQ, z, av, (int *)x); }
+      else {
+        y = aslot(); z = vpop();
+        if (alive((int *)x)) { rop(2, RMOV, tslot(vd + 2), z, 0); z = tslot(vd + 2); canon(1); y = av; }
+        else canon(0);
+        rbr(RJEQ + i - BEQ, z, y, (int *)x);
+      }
+    }
+    else if (i == LEV) { if (ak == VA) rop(0, RLEV, 0, 0, 0); else rop(1, RRET, aslot(), 0, 0); reach = 0; }
+    else if (i == LI) {
+      if (ak == VL) ak = VS;
+      else if (ak == VK) rval(2, RLGI, av, 0);
+      else rval(2, RLI, aslot(), 0);
+    }
+    else if (i == LC) rval(2, RLC, aslot(), 0);
+    // A store through a pointer may write any local. // 透過指標的儲存可能寫入任何區域變數
+    else if (i == SI) {
+      if (vk[vd - 1] == VL) rstore(vv[--vd]);
+      else if (vk[vd - 1] == VK) { y = aslot(); rop(2, RSGI, vv[--vd], y, 0); }
+      else { y = aslot(); z = vpop(); vflush(0); rop(2, RSI, z, y, 0); }
+    }
+    else if (i == SC) { y = aslot(); z = vpop(); vflush(0); rval(3, RSC, z, y); }
+    else if (i == PSH) vpush();
+    else if (i >= OR && i <= MOD) {
+      if (ak == VK && vk[vd - 1] == VK && !((i == DIV || i == MOD) && !av)) { --vd; av = fold(i, vv[vd], av); }
+      else if (ak == VK) { z = vpop(); rval(3, RORK + i - OR, z, av); }
+      else { y = aslot(); z = vpop(); rval(3, ROR + i - OR, z, y); }
+    }
+    // System calls read their arguments from the stack, like the stack VM. // 系統呼叫像堆疊虛擬機一樣從堆疊讀取參數
+    else if (i >= OPEN && i <= EXIT) {
+      y = 0; while (y < vd) vmat(y++);
+      rop(3, RSYS, i, rloc + vd, (i == OPEN || i == PRTF) ? pc[1] : 0);
+      ak = VA;
+    }
+    else { printf("register VM: unknown instruction = %d\n", i); exit(-1); }
+  }
+  if (f) *f = rloc + rmax + 2;
+
+  // `main` returns to `HALT`. // `main` 返回到 `HALT`
+  rop(0, RHALT, 0, 0, 0); rhalt = re;
+
+  // Patch the branches now that every target has an address. // 所有目標都有位址後, 修補分支
+  while (rfp > rfix) { rfp = rfp - 2; *(int *)*rfp = (int)rmap[(int *)rfp[1] - text]; }
+}
+
+// Run system call `i` other than `exit`, whose arguments are on the VM // 執行 `exit` 以外的系統呼叫 `i`, 其參數在位於 `sp` 的虛擬機堆疊上
+// stack at `sp`. `open` and `printf` take a variable number of arguments, // `open` 和 `printf` 的參數數量不固定,
+// which end below `t`. // 參數結束於 `t` 之下
+int rsys(int i, int *sp, int *t)
+{
+  if (i == OPEN) return open((char *)t[-1], t[-2], t[-3]);
+  if (i == READ) return oread(sp[2], (char *)sp[1], *sp);
+  if (i == CLOS) return close(*sp);
+  if (i == PRTF) return oprintf(t, t - sp);
+  if (i == MALC) return (int)gmalloc(*sp);
+  if (i == FREE) { gfree((char *)*sp); return 0; }
+  if (i == MSET) return (int)memset((char *)sp[2], sp[1], *sp);
+  if (i == MCMP) return memcmp((char *)sp[2], (char *)sp[1], *sp);
+  if (i == MCPY) return (int)memcpy((char *)sp[2], (char *)sp[1], *sp);
+  if (i == MCHR) return (int)memchr((char *)sp[2], sp[1], *sp);
+  if (i == SLEN) return strlen((char *)*sp);
+  if (i == SCMP) return strcmp((char *)sp[1], (char *)*sp);
+  if (i == SCHR) return (int)strchr((char *)sp[1], *sp);
+  if (i == MMAP) return (int)mmap((char *)sp[5], sp[4], sp[3], sp[2], sp[1], *sp);
+  if (i == LSEK) return lseek(sp[2], sp[1], *sp);
+  if (i == MUNM) return munmap((char *)sp[1], *sp);
+  if (i == FSTA) return fstat(sp[1], (void *)*sp);
+  if (i == MRST) return greset();
+  return owrite(sp[2], (char *)sp[1], *sp);
+}
+
+// Run register code from `entry` with VM stack top `sp`, passing `argc` // 以虛擬機堆疊頂端 `sp` 從 `entry` 執行暫存器碼,
+// and `argv` to `main`. Return the exit code. // 並將 `argc` 和 `argv` 傳給 `main`. 回傳離開代碼
+int rrun(int *entry, int *sp, int argc, char **argv)
+{
+  int *pc, *bp, a, cycle, i, *t;
+
+  *--sp = argc; *--sp = (int)argv; *--sp = (int)rhalt;
+  pc = entry; bp = sp; a = 0; cycle = 0;
+
+#if defined(__GNUC__)
+  // Threaded dispatch, as for the stack VM. // 與堆疊虛擬機相同的串接式分派
+  {
+    static void *rtab[] = {
+      &&r_MOV, &&r_MOVK, &&r_LEA, &&r_GETA, &&r_LI, &&r_LC, &&r_LGI, &&r_SI, &&r_SC, &&r_SGI,
+      &&r_OR, &&r_XOR, &&r_AND, &&r_EQ, &&r_NE, &&r_LT, &&r_GT, &&r_LE, &&r_GE, &&r_SHL, &&r_SHR, &&r_ADD, &&r_SUB, &&r_MUL, &&r_DIV, &&r_MOD,
+      &&r_ORK, &&r_XORK, &&r_ANDK, &&r_EQK, &&r_NEK, &&r_LTK, &&r_GTK, &&r_LEK, &&r_GEK, &&r_SHLK, &&r_SHRK, &&r_ADDK, &&r_SUBK, &&r_MULK, &&r_DIVK, &&r_MODK,
+      &&r_JMP, &&r_JZ, &&r_JNZ, &&r_JEQ, &&r_JNE, &&r_JLT, &&r_JGT, &&r_JLE, &&r_JGE, &&r_JEQK, &&r_JNEK, &&r_JLTK, &&r_JGTK, &&r_JLEK, &&r_JGEK, &&r_JTAB,
+      &&r_CALL, &&r_TCALL, &&r_ENT, &&r_RET, &&r_LEV, &&r_SYS, &&r_HALT };
+
+#define RNEXT ++cycle; goto *rtab[*pc++]
+    RNEXT;
+
+    // Same semantics as the `if` chain below. // 語意與下面的 `if` 串列相同
+    r_MOV:  bp[*pc] = bp[pc[1]]; pc = pc + 2;                          RNEXT;
+    r_MOVK: bp[*pc] = pc[1]; pc = pc + 2;                              RNEXT;
+    r_LEA:  bp[*pc] = (int)(bp + pc[1]); pc = pc + 2;                  RNEXT;
+    r_GETA: bp[*pc++] = a;                                             RNEXT;
+    r_LI:   bp[*pc] = *(int *)bp[pc[1]]; pc = pc + 2;                  RNEXT;
+    r_LC:   bp[*pc] = *(char *)bp[pc[1]]; pc = pc + 2;                 RNEXT;
+    r_LGI:  bp[*pc] = *(int *)pc[1]; pc = pc + 2;                      RNEXT;
+    r_SI:   *(int *)bp[*pc] = bp[pc[1]]; pc = pc + 2;                  RNEXT;
+    r_SC:   bp[*pc] = *(char *)bp[pc[1]] = bp[pc[2]]; pc = pc + 3;     RNEXT;
+    r_SGI:  *(int *)*pc = bp[pc[1]]; pc = pc + 2;                      RNEXT;
+    r_OR:   bp[*pc] = bp[pc[1]] |  bp[pc[2]]; pc = pc + 3;             RNEXT;
+    r_XOR:  bp[*pc] = bp[pc[1]] ^  bp[pc[2]]; pc = pc + 3;             RNEXT;
+    r_AND:  bp[*pc] = bp[pc[1]] &  bp[pc[2]]; pc = pc + 3;             RNEXT;
+    r_EQ:   bp[*pc] = bp[pc[1]] == bp[pc[2]]; pc = pc + 3;             RNEXT;
+    r_NE:   bp[*pc] = bp[pc[1]] != bp[pc[2]]; pc = pc + 3;             RNEXT;
+    r_LT:   bp[*pc] = bp[pc[1]] <  bp[pc[2]]; pc = pc + 3;             RNEXT;
+    r_GT:   bp[*pc] = bp[pc[1]] >  bp[pc[2]]; pc = pc + 3;             RNEXT;
+    r_LE:   bp[*pc] = bp[pc[1]] <= bp[pc[2]]; pc = pc + 3;             RNEXT;
+    r_GE:   bp[*pc] = bp[pc[1]] >= bp[pc[2]]; pc = pc + 3;             RNEXT;
+    r_SHL:  bp[*pc] = bp[pc[1]] << bp[pc[2]]; pc = pc + 3;             RNEXT;
+    r_SHR:  bp[*pc] = bp[pc[1]] >> bp[pc[2]]; pc = pc + 3;             RNEXT;
+    r_ADD:  bp[*pc] = bp[pc[1]] +  bp[pc[2]]; pc = pc + 3;             RNEXT;
+    r_SUB:  bp[*pc] = bp[pc[1]] -  bp[pc[2]]; pc = pc + 3;             RNEXT;
+    r_MUL:  bp[*pc] = bp[pc[1]] *  bp[pc[2]]; pc = pc + 3;             RNEXT;
+    r_DIV:  bp[*pc] = bp[pc[1]] /  bp[pc[2]]; pc = pc + 3;             RNEXT;
+    r_MOD:  bp[*pc] = bp[pc[1]] %  bp[pc[2]]; pc = pc + 3;             RNEXT;
+    r_ORK:  bp[*pc] = bp[pc[1]] |  pc[2]; pc = pc + 3;                 RNEXT;
+    r_XORK: bp[*pc] = bp[pc[1]] ^  pc[2]; pc = pc + 3;                 RNEXT;
+    r_ANDK: bp[*pc] = bp[pc[1]] &  pc[2]; pc = pc + 3;                 RNEXT;
+    r_EQK:  bp[*pc] = bp[pc[1]] == pc[2]; pc = pc + 3;                 RNEXT;
+    r_NEK:  bp[*pc] = bp[pc[1]] != pc[2]; pc = pc + 3;                 RNEXT;
+    r_LTK:  bp[*pc] = bp[pc[1]] <  pc[2]; pc = pc + 3;                 RNEXT;
+    r_GTK:  bp[*pc] = bp[pc[1]] >  pc[2]; pc = pc + 3;                 RNEXT;
+    r_LEK:  bp[*pc] = bp[pc[1]] <= pc[2]; pc = pc + 3;                 RNEXT;
+    r_GEK:  bp[*pc] = bp[pc[1]] >= pc[2]; pc = pc + 3;                 RNEXT;
+    r_SHLK: bp[*pc] = bp[pc[1]] << pc[2]; pc = pc + 3;                 RNEXT;
+    r_SHRK: bp[*pc] = bp[pc[1]] >> pc[2]; pc = pc + 3;                 RNEXT;
+    r_ADDK: bp[*pc] = bp[pc[1]] +  pc[2]; pc = pc + 3;                 RNEXT;
+    r_SUBK: bp[*pc] = bp[pc[1]] -  pc[2]; pc = pc + 3;                 RNEXT;
+    r_MULK: bp[*pc] = bp[pc[1]] *  pc[2]; pc = pc + 3;                 RNEXT;
+    r_DIVK: bp[*pc] = bp[pc[1]] /  pc[2]; pc = pc + 3;                 RNEXT;
+    r_MODK: bp[*pc] = bp[pc[1]] %  pc[2]; pc = pc + 3;                 RNEXT;
+    r_JMP:  pc = (int *)*pc;                                           RNEXT;
+    r_JZ:   pc = bp[*pc] ? pc + 2 : (int *)pc[1];                      RNEXT;
+    r_JNZ:  pc = bp[*pc] ? (int *)pc[1] : pc + 2;                      RNEXT;
+    r_JEQ:  pc = bp[*pc] == bp[pc[1]] ? (int *)pc[2] : pc + 3;         RNEXT;
+    r_JNE:  pc = bp[*pc] != bp[pc[1]] ? (int *)pc[2] : pc + 3;         RNEXT;
+    r_JLT:  pc = bp[*pc] <  bp[pc[1]] ? (int *)pc[2] : pc + 3;         RNEXT;
+    r_JGT:  pc = bp[*pc] >  bp[pc[1]] ? (int *)pc[2] : pc + 3;         RNEXT;
+    r_JLE:  pc = bp[*pc] <= bp[pc[1]] ? (int *)pc[2] : pc + 3;         RNEXT;
+    r_JGE:  pc = bp[*pc] >= bp[pc[1]] ? (int *)pc[2] : pc + 3;         RNEXT;
+    r_JEQK: pc = bp[*pc] == pc[1] ? (int *)pc[2] : pc + 3;             RNEXT;
+    r_JNEK: pc = bp[*pc] != pc[1] ? (int *)pc[2] : pc + 3;             RNEXT;
+    r_JLTK: pc = bp[*pc] <  pc[1] ? (int *)pc[2] : pc + 3;             RNEXT;
+    r_JGTK: pc = bp[*pc] >  pc[1] ? (int *)pc[2] : pc + 3;             RNEXT;
+    r_JLEK: pc = bp[*pc] <= pc[1] ? (int *)pc[2] : pc + 3;             RNEXT;
+    r_JGEK: pc = bp[*pc] >= pc[1] ? (int *)pc[2] : pc + 3;             RNEXT;
+    r_JTAB: i = bp[*pc]; pc = (int *)pc[(i >= 0 && i < pc[1]) ? i + 2 : pc[1] + 2]; RNEXT;
+    r_CALL: sp = bp - *pc; *--sp = (int)(pc + 2); pc = (int *)pc[1];   RNEXT;
+    r_TCALL: i = pc[1]; t = bp - *pc; while (i) { --i; bp[i + 2] = t[i]; }
+            sp = bp + 1; bp = (int *)*bp; pc = (int *)pc[2];          RNEXT;
+    r_ENT:  *--sp = (int)bp; bp = sp;
+            if (bp - *pc++ < slim) { oflush(); printf("stack overflow\n"); return -1; } RNEXT;
+    r_RET:  a = bp[*pc]; sp = bp; bp = (int *)*sp++; pc = (int *)*sp++; RNEXT;
+    r_LEV:  sp = bp; bp = (int *)*sp++; pc = (int *)*sp++;             RNEXT;
+    r_SYS:  i = *pc; sp = bp - pc[1]; t = sp + pc[2]; pc = pc + 3;
+            if (i == EXIT) { oflush(); printf("exit(%d) cycle = %d\n", *sp, cycle); return *sp; }
+            a = rsys(i, sp, t);                                        RNEXT;
+    r_HALT: oflush(); printf("exit(%d) cycle = %d\n", a, cycle); return a;
+#undef RNEXT
+  }
+#endif
+
+  while (1) {
+    i = *pc++; ++cycle;
+    if      (i == RMOV)  { bp[*pc] = bp[pc[1]]; pc = pc + 2; }
+    else if (i == RMOVK) { bp[*pc] = pc[1]; pc = pc + 2; }
+    else if (i == RLEA)  { bp[*pc] = (int)(bp + pc[1]); pc = pc + 2; }
+    else if (i == RGETA) bp[*pc++] = a;
+    else if (i == RLI)   { bp[*pc] = *(int *)bp[pc[1]]; pc = pc + 2; }
+    else if (i == RLC)   { bp[*pc] = *(char *)bp[pc[1]]; pc = pc + 2; }
+    else if (i == RLGI)  { bp[*pc] = *(int *)pc[1]; pc = pc + 2; }
+    else if (i == RSI)   { *(int *)bp[*pc] = bp[pc[1]]; pc = pc + 2; }
+    else if (i == RSC)   { bp[*pc] = *(char *)bp[pc[1]] = bp[pc[2]]; pc = pc + 3; }
+    else if (i == RSGI)  { *(int *)*pc = bp[pc[1]]; pc = pc + 2; }
+    // `OR` .. `MOD` are in the same order as the stack VM's. // `OR` .. `MOD` 的順序與堆疊虛擬機相同
+    else if (i <= RMOD)  { bp[*pc] = fold(i - ROR + OR, bp[pc[1]], bp[pc[2]]); pc = pc + 3; }
+    else if (i <= RMODK) { bp[*pc] = fold(i - RORK + OR, bp[pc[1]], pc[2]); pc = pc + 3; }
+    else if (i == RJMP)  pc = (int *)*pc;
+    else if (i == RJZ)   pc = bp[*pc] ? pc + 2 : (int *)pc[1];
+    else if (i == RJNZ)  pc = bp[*pc] ? (int *)pc[1] : pc + 2;
+    else if (i <= RJGE)  pc = fold(i - RJEQ + EQ, bp[*pc], bp[pc[1]]) ? (int *)pc[2] : pc + 3;
+    else if (i <= RJGEK) pc = fold(i - RJEQK + EQ, bp[*pc], pc[1]) ? (int *)pc[2] : pc + 3;
+    else if (i == RJTAB) { i = bp[*pc]; pc = (int *)pc[(i >= 0 && i < pc[1]) ? i + 2 : pc[1] + 2]; }
+    else if (i == RCALL) { sp = bp - *pc; *--sp = (int)(pc + 2); pc = (int *)pc[1]; }
+    else if (i == RTCALL) {
+      i = pc[1]; t = bp - *pc; while (i) { --i; bp[i + 2] = t[i]; }
+      sp = bp + 1; bp = (int *)*bp; pc = (int *)pc[2];
+    }
+    else if (i == RENT)  { *--sp = (int)bp; bp = sp; if (bp - *pc++ < slim) { oflush(); printf("stack overflow\n"); return -1; } }
+    else if (i == RRET)  { a = bp[*pc]; sp = bp; bp = (int *)*sp++; pc = (int *)*sp++; }
+    else if (i == RLEV)  { sp = bp; bp = (int *)*sp++; pc = (int *)*sp++; }
+    else if (i == RSYS) {
+      i = *pc; sp = bp - pc[1]; t = sp + pc[2]; pc = pc + 3;
+      if (i == EXIT) { oflush(); printf("exit(%d) cycle = %d\n", *sp, cycle); return *sp; }
+      a = rsys(i, sp, t);
+    }
+    else if (i == RHALT) { oflush(); printf("exit(%d) cycle = %d\n", a, cycle); return a; }
+    else { oflush(); printf("unknown register instruction = %d! cycle = %d\n", i, cycle); return -1; }
+  }
+}
+
+// Parse a size such as `65536`, `64k` or `16m`. // 解析大小, 例如 `65536`, `64k` 或 `16m`
+int argsize(char *s)
+{
+  int n;
+
+  n = 0;
+  while (*s >= '0' && *s <= '9') n = n * 10 + *s++ - '0';
+  if (*s == 'k' || *s == 'K') n = n << 10;
+  else if (*s == 'm' || *s == 'M') n = n << 20;
+  else if (*s == 'g' || *s == 'G') n = n << 30;
+  return n;
+}
+
+// Write all `n` bytes at `b` to `fd`, retrying short writes. // 將 `b` 的 `n` 個位元組全部寫入 `fd`, 並重試不完整的寫入
+// Return 0, or -1 on error. // 回傳 0, 錯誤時回傳 -1
+int writeall(int fd, char *b, int n)
+{
+  int i;
+
+  while (n > 0) {
+    if ((i = write(fd, b, n)) <= 0) return -1;
+    b = b + i; n = n - i;
+  }
+  return 0;
+}
+
+// Write the compiled program to the bytecode image file `name` for `-o`. // 為 `-o` 將編譯好的程式寫入位元組碼映像檔 `name`
+// `entry` is `main`'s address. Code and data addresses in the text segment // `entry` 是 `main` 的位址
+// are absolute, so they are turned into offsets and their positions are // 程式碼段中的程式碼與資料位址是絕對位址,
+// written as the relocation table: word index * 2, plus 1 for a data // 所以將它們轉成位移, 並將其位置寫成重定位表:
+// address. Jump operands are code addresses, and an `IMM`, `LGI` or `SGI` // 字組索引 * 2, 資料位址再加 1
+// operand in the data segment is taken to be a data address. // 跳轉的運算元是程式碼位址, 而落在資料段內的 `IMM`, `LGI` 或 `SGI` 運算元視為資料位址
+int save(char *name, int *entry)
+{
+  int *hdr, *rel, *t, n, i, fd;
+
+  hdr = malloc(Hdrsz * sizeof(int));
+  rel = malloc((e - text + 1) * sizeof(int));
+  if (!hdr || !rel) { printf("could not malloc relocation table\n"); return -1; }
+
+  // Find the pointers and turn them into offsets. // 找出指標並轉成位移
+  n = 0; t = text + 1;
+  while (t <= e) {
+    i = *t++;
+    if (i <= BGE) {
+      if (isjmp(i)) { rel[n++] = (t - text) * 2; *t = *t - (int)text; }
+      else if ((i == IMM || i == LGI || i == SGI) && *t >= (int)dbase && *t <= (int)data) { rel[n++] = (t - text) * 2 + 1; *t = *t - (int)dbase; }
+      ++t;
+    }
+  }
+
+  hdr[Magic] = C4B; hdr[Ntext] = e - text + 1; hdr[Ndata] = data - dbase; hdr[Entry] = entry - text; hdr[Nrel] = n;
+  if ((fd = open(name, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) { printf("could not open(%s)\n", name); return -1; }
+  if (writeall(fd, (char *)hdr, Hdrsz * sizeof(int)) || writeall(fd, (char *)text, hdr[Ntext] * sizeof(int)) ||
+      writeall(fd, dbase, hdr[Ndata]) || writeall(fd, (char *)rel, n * sizeof(int))) {
+    printf("could not write(%s)\n", name); return -1;
+  }
+  close(fd);
+  return 0;
+}
+
+// Load the bytecode image `b` of `n` bytes, written by `save`, into the // 將由 `save` 寫出的 `n` 位元組位元組碼映像 `b`
+// text and data segments and relocate it. Return `main`'s address. // 載入程式碼段和資料段並重定位; 回傳 `main` 的位址
+int *load(int *b, int n)
+{
+  int *t, *r, i;
+
+  // The counts must be within the image, which also keeps their sum from // 各數量必須在映像之內, 這也避免其總和溢位,
+  // overflowing, and the entry must be in the text segment. // 而入口必須在程式碼段中
+  if (n < Hdrsz * sizeof(int) || b[Ntext] < 0 || b[Ndata] < 0 || b[Nrel] < 0 ||
+      b[Ntext] > n || b[Ndata] > n || b[Nrel] > n ||
+      n < (Hdrsz + b[Ntext] + b[Nrel]) * sizeof(int) + b[Ndata] ||
+      b[Entry] < 0 || b[Entry] >= b[Ntext]) { printf("bad bytecode image\n"); exit(-1); }
+  if (text + b[Ntext] > tlim) { printf("text area full\n"); exit(-1); }
+  if (dbase + b[Ndata] > dlim) { printf("data area full\n"); exit(-1); }
+
+  // Copy the segments, a word at a time. // 逐字組複製各段
+  t = b + Hdrsz; i = 0;
+  while (i < b[Ntext]) { text[i] = t[i]; ++i; }
+  e = text + i - 1;
+  t = t + i; r = (int *)dbase; i = 0;
+  while (i < b[Ndata] / sizeof(int)) { r[i] = t[i]; ++i; }
+  data = dbase + b[Ndata];
+
+  // Add the segment addresses back. // 加回各段的位址
+  r = t + i; i = 0;
+  while (i < b[Nrel]) {
+    if (r[i] < 0 || (r[i] >> 1) >= b[Ntext]) { printf("bad bytecode image\n"); exit(-1); }
+    t = text + (r[i] >> 1);
+    *t = *t + ((r[i] & 1) ? (int)dbase : (int)text);
+    ++i;
+  }
+  return text + b[Entry];
+}
+
+// Execution profiler for `-p`. // `-p` 使用的執行剖析器
+// Counts executions per opcode, and calls and inclusive/exclusive cycles per // 計算每個操作碼的執行次數, 以及每個函數的呼叫次數和包含/不包含被呼叫者的週期數
+// function, identified by the address of its `ENT`. Only counters change // 函數以其 `ENT` 的位址識別
+// while the program runs; `pdump` prints the sorted report at exit. // 程式執行時只更新計數器; `pdump` 在結束時印出排序後的報告
+
+// Per function fields, at `ENT`'s offset in the text segment * `Psz`: // 每個函數的字段, 位於 `ENT` 在程式碼段中的位移 * `Psz`:
+// `Pcalls`: Number of calls. // 呼叫次數
+// `Pincl`: Cycles including callees, for the outermost active call only. // 包含被呼叫者的週期數, 只計算最外層的呼叫
+// `Pexcl`: Cycles excluding callees. // 不包含被呼叫者的週期數
+// `Pact`: Number of active calls. // 進行中的呼叫數量
+enum { Pcalls, Pincl, Pexcl, Pact, Psz };
+
+#if defined(__GNUC__)
+__thread
+#endif
+int *popc,   // executions per opcode // 每個操作碼的執行次數
+    *pfn,    // per function fields // 每個函數的字段
+    *plist,  // `ENT` offsets of the functions called, in first call order // 被呼叫過的函數的 `ENT` 位移, 依第一次呼叫的順序
+    pn,      // number of functions called // 被呼叫過的函數數量
+    *pstk,   // call stack: `ENT` offset, cycle at entry, cycles in callees // 呼叫堆疊: `ENT` 位移, 進入時的週期, 被呼叫者的週期數
+    *pcnt,   // executions per text word, for `-l` // 每個程式碼字組的執行次數, 供 `-l` 使用
+    *psp;    // top of `pstk` // `pstk` 的頂端
+
+// Enter the function whose `ENT` is at `ent`, at cycle `c`. // 在週期 `c` 進入 `ENT` 位於 `ent` 的函數
+void penter(int *ent, int c)
+{
+  int *f;
+
+  f = pfn + (ent - text) * Psz;
+  if (!f[Pcalls]++) plist[pn++] = ent - text;
+  ++f[Pact];
+  *psp++ = ent - text; *psp++ = c; *psp++ = 0;
+}
+
+// Leave the innermost function at cycle `c`. // 在週期 `c` 離開最內層的函數
+void pleave(int c)
+{
+  int *f, n;
+
+  psp = psp - 3;
+  f = pfn + *psp * Psz;
+  n = c - psp[1];
+  f[Pexcl] = f[Pexcl] + n - psp[2];
+  if (!--f[Pact]) f[Pincl] = f[Pincl] + n;
+  if (psp > pstk) psp[-1] = psp[-1] + n;
+}
+
+// Sort the `n` indexes at `a` by `key[index * k]`, largest first. // 依 `key[index * k]` 由大到小排序 `a` 中的 `n` 個索引
+void psort(int *a, int n, int *key, int k)
+{
+  int i, j, m, t;
+
+  i = 0;
+  while (i < n) {
+    m = i; j = i + 1;
+    while (j < n) { if (key[a[j] * k] > key[a[m] * k]) m = j; ++j; }
+    t = a[i]; a[i] = a[m]; a[m] = t;
+    ++i;
+  }
+}
+
+// Print the profile of a run of `c` cycles. // 印出執行 `c` 個週期的剖析報告
+void pdump(int c)
+{
+  int *a, *f, *d, i, n;
+  char *s;
+
+  // Close the calls still active, e.g. when `exit` is called. // 結束仍在進行中的呼叫, 例如呼叫 `exit` 時
+  while (psp > pstk) pleave(c);
+  if (c < 1) c = 1;
+
+  // Opcodes by executions. // 依執行次數排列的操作碼
+  a = malloc((EXIT + 1) * sizeof(int));
+  n = 0; i = 0;
+  while (i <= EXIT) { if (popc[i]) a[n++] = i; ++i; }
+  psort(a, n, popc, 1);
+  printf("\nopcode        count      %%\n");
+  i = 0;
+  while (i < n) {
+    printf("%.4s %12d %3d.%d\n", &opname[a[i] * 5], popc[a[i]], popc[a[i]] * 100 / c, popc[a[i]] * 1000 / c % 10);
+    ++i;
+  }
+  free(a);
+
+  // Functions by exclusive cycles, named from the symbol table. // 依不包含被呼叫者的週期數排列的函數, 名稱取自符號表
+  psort(plist, pn, pfn + Pexcl, Psz);
+  printf("\nfunction                     calls         incl         excl      %%\n");
+  i = 0;
+  while (i < pn) {
+    f = pfn + plist[i] * Psz;
+    d = sym; while (d < symend && (d[Class] != Fun || d[Val] != (int)(text + plist[i]))) d = d + Idsz;
+    if (d < symend) {
+      s = (char *)d[Name]; n = 0;
+      while ((s[n] >= 'a' && s[n] <= 'z') || (s[n] >= 'A' && s[n] <= 'Z') || (s[n] >= '0' && s[n] <= '9') || s[n] == '_') ++n;
+      printf("%-20.*s", n, s);
+    }
+    // Images loaded from `-o` have no symbols. // 由 `-o` 載入的映像沒有符號
+    else printf("@%-19d", plist[i]);
+    printf(" %12d %12d %12d", f[Pcalls], f[Pincl], f[Pexcl]);
+    printf(" %3d.%d\n", f[Pexcl] * 100 / c, f[Pexcl] * 1000 / c % 10);
+    ++i;
+  }
+}
+
+// Print the source with executions per line for `-l`, out of `c` cycles, // 為 `-l` 印出附有每行執行次數的原始碼, 總共 `c` 個週期,
+// marking the ten hottest lines with `>`. Each word's executions go to // 並以 `>` 標示最熱的十行
+// the line whose code contains it, as found in `lnt`. // 每個字組的執行次數歸給 `lnt` 中包含它的那一行
+void ldump(int c)
+{
+  int *n, *a, *t, i, j, m;
+  char *s, *hot;
+
+  if (lnp == lnt) { printf("\nno line table\n"); return; }
+  if (c < 1) c = 1;
+  n = malloc((line + 1) * sizeof(int)); a = malloc((line + 1) * sizeof(int)); hot = malloc(line + 1);
+  memset(n, 0, (line + 1) * sizeof(int)); memset(hot, 0, line + 1);
+
+  // Add up the executions of each line's words. // 加總每行各字組的執行次數
+  t = lnt;
+  while (t < lnp) {
+    i = *t; j = (t + 2 < lnp) ? t[2] : e + 1 - text;
+    while (i < j) n[t[1]] = n[t[1]] + pcnt[i++];
+    t = t + 2;
+  }
+
+  // Rank the lines that ran and mark the ten hottest. // 排列執行過的行並標示最熱的十行
+  m = 0; i = 1;
+  while (i <= line) { if (n[i]) a[m++] = i; ++i; }
+  psort(a, m, n, 1);
+  printf("\nhot line        count      %%\n");
+  i = 0;
+  while (i < m && i < 10) {
+    hot[a[i]] = 1;
+    printf("%8d %12d %3d.%d\n", a[i], n[a[i]], n[a[i]] * 100 / c, n[a[i]] * 1000 / c % 10);
+    ++i;
+  }
+
+  // Print the annotated source. // 印出附註的原始碼
+  printf("\n       count      %%\n");
+  s = sbuf; i = 1;
+  while (*s) {
+    t = (int *)s; while (*s && *s != '\n') ++s;
+    if (n[i]) printf("%12d %3d.%d %c", n[i], n[i] * 100 / c, n[i] * 1000 / c % 10, hot[i] ? '>' : ' ');
+    else printf("                    ");
+    printf("%5d: %.*s\n", i, s - (char *)t, (char *)t);
+    if (*s) ++s;
+    ++i;
+  }
+  free(n); free(a); free(hot);
+}
+
+#if defined(__GNUC__)
+// Split `s` .. `t - 1` in place into words separated by blanks, store them // 將 `s` .. `t - 1` 就地切成以空白分隔的單字,
+// in `v` followed by a 0, and return their number. `v` needs room for // 存入 `v` 並在之後放一個 0, 回傳單字數量.
+// `(t - s) / 2 + 2` pointers. // `v` 需要可容納 `(t - s) / 2 + 2` 個指標的空間
+int split(char *s, char *t, char **v)
+{
+  int c;
+
+  c = 0;
+  while (s < t) {
+    if (*s == ' ' || *s == '\t') *s++ = 0;
+    else { v[c++] = s; while (s < t && *s != ' ' && *s != '\t') ++s; }
+  }
+  v[c] = 0;
+  return c;
+}
+
+// `--serve`: compile once, then run the program once per request on Unix // `--serve`: 只編譯一次, 然後對 Unix socket `path` 上的每個請求執行一次程式
+// socket `path`. A request is one line of blank separated arguments; the // 請求是一行以空白分隔的參數;
+// program's output, ending with its `exit(...)` line, is the reply. Each // 程式的輸出 (以其 `exit(...)` 行結束) 就是回覆
+// request is served by a child forked from the compiled program just // 每個請求由一個在虛擬機開始之前, 從已編譯程式 fork 出來的子行程處理,
+// before the VM starts, so it shares the text and data copy-on-write and // 所以它以寫入時複製的方式共用程式碼和資料,
+// costs a fork plus the run, with no lexing or parsing. // 只需要一次 fork 加上執行, 不需要詞法或語法分析
+// The server never returns. In each child, return the guest's `argc` and // 伺服器永不返回. 在每個子行程中, 回傳客體程式的 `argc`
+// point `*av` at its `argv`, whose `argv[0]` is the old `(*av)[0]`. // 並將 `*av` 指向其 `argv`, 其 `argv[0]` 是原本的 `(*av)[0]`
+// Return -1 if the socket cannot be set up. // 無法建立 socket 時回傳 -1
+int serve(char *path, char ***av)
+{
+  struct sockaddr_un sa;
+  char *b, *t, **v;
+  int s, c, n, k;
+
+  memset(&sa, 0, sizeof(sa)); sa.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(sa.sun_path)) { printf("socket path too long: %s\n", path); return -1; }
+  strcpy(sa.sun_path, path); unlink(path);
+  if ((s = socket(AF_UNIX, SOCK_STREAM, 0)) < 0 || bind(s, (struct sockaddr *)&sa, sizeof(sa)) || listen(s, 128)) {
+    printf("could not listen on %s\n", path); return -1;
+  }
+
+  // Let finished children be reaped automatically, and flush what was // 讓結束的子行程自動被回收, 並在 fork 之前
+  // printed so far before forking. // 先輸出到目前為止印出的內容
+  signal(SIGCHLD, SIG_IGN);
+  printf("serving %s\n", path); fflush(stdout);
+  while (1) {
+    if ((c = accept(s, 0, 0)) < 0) continue;
+    // If the fork fails, the client just sees the connection closed. // 如果 fork 失敗, 客戶端只會看到連線被關閉
+    if (fork()) { close(c); continue; }
+
+    // The child reads its request line and replies on the connection. // 子行程讀取其請求行並在連線上回覆
+    close(s);
+    b = malloc(65536); n = 0;
+    while (n < 65535 && (k = read(c, b + n, 65535 - n)) > 0) { n = n + k; if (memchr(b + n - k, '\n', k)) break; }
+    if ((t = memchr(b, '\n', n))) n = t - b;
+    b[n] = 0;
+    dup2(c, 1); dup2(c, 2); close(c);
+    v = malloc((n / 2 + 3) * sizeof(char *));
+    *v = **av; *av = v;
+    return split(b, b + n, v + 1) + 1;
+  }
+}
+
+int dfd; // `--diff` child's pipe for the hash of its globals // `--diff` 子行程傳送全域變數雜湊值的管道
+
+// At exit of a `--diff` child, send the FNV-1a hash of the data segment. // `--diff` 子行程結束時, 送出資料段的 FNV-1a 雜湊值
+void dsend()
+{
+  unsigned long long h;
+  char *q;
+
+  h = 14695981039346656037ULL; q = dbase;
+  while (q < data) h = (h ^ (unsigned char)*q++) * 1099511628211ULL;
+  write(dfd, &h, sizeof(h));
+}
+
+// Fork a `--diff` child for the stack VM (`r` 0) or the register VM (`r` // 為堆疊虛擬機 (`r` 為 0) 或暫存器虛擬機 (`r` 為 1) fork 一個 `--diff` 子行程
+// 1), with its output and the hash of its globals going to the pipes // 其輸出和全域變數的雜湊值送往管道 `o` 和 `d`
+// `o` and `d`. Return -1 in the child and its pid in the parent, which // 在子行程中回傳 -1, 在父行程中回傳其 pid,
+// keeps the pipes' read ends. // 父行程保留管道的讀取端
+int dchild(int r, cint *o, cint *d)
+{
+  int pid;
+
+  if (pipe(o) || pipe(d) || (pid = fork()) < 0) { printf("could not fork\n"); exit(-1); }
+  if (!pid) {
+    close(o[0]); close(d[0]); dup2(o[1], 1); close(o[1]);
+    dfd = d[1]; atexit(dsend); regvm = r; jit = 0;
+    return -1;
+  }
+  close(o[1]); close(d[1]);
+  return pid;
+}
+
+// Collect a `--diff` child's output from pipe `o` in `*b` and `*n`, the // 從管道 `o` 將 `--diff` 子行程的輸出收集到 `*b` 和 `*n`,
+// hash of its globals from pipe `d` in `*h` and how it ended in `*si`. // 從管道 `d` 將其全域變數的雜湊值收集到 `*h`, 其結束方式收集到 `*si`
+void dcollect(int pid, int o, int d, char **b, int *n, int *h, siginfo_t *si)
+{
+  int k, c;
+
+  *n = 0; k = 4096; *b = malloc(k);
+  while ((c = read(o, *b + *n, k - *n)) > 0) { *n = *n + c; if (*n == k) *b = realloc(*b, k = k * 2); }
+  close(o);
+  *h = 0; read(d, h, sizeof(*h)); close(d);
+  waitid(P_PID, pid, si, WEXITED);
+}
+
+// `--diff`: run the program on the stack VM and on the register VM, each // `--diff`: 在堆疊虛擬機和暫存器虛擬機上執行程式, 各在一個子行程中,
+// in a child, and compare what they print before the `exit(...)` line, // 並比較它們在 `exit(...)` 行之前印出的內容,
+// how they end and their globals at exit. Print the stack VM's output and // 結束方式, 以及結束時的全域變數. 印出堆疊虛擬機的輸出和比較結果,
+// the verdict, and return 0 if they agree, else 1. Return -1 in the // 一致時回傳 0, 否則回傳 1
+// children, which go on to run their VM. // 在子行程中回傳 -1, 子行程接著執行其虛擬機
+// Both children are forked before the parent allocates anything, so their // 兩個子行程都在父行程配置任何東西之前 fork,
+// heaps match and so do globals that point into them. // 所以它們的堆積相同, 指向其中的全域變數也相同
+int differ()
+{
+  char *b[2];
+  int n[2], m[2], h[2], pid[2], i, j, r;
+  cint o[4], d[4];
+  siginfo_t si[2];
+
+  fflush(stdout);
+  i = 0;
+  while (i < 2) {
+    if ((pid[i] = dchild(i, o + i * 2, d + i * 2)) < 0) {
+      if (i) { close(o[0]); close(d[0]); }
+      return -1;
+    }
+    ++i;
+  }
+  i = 0;
+  while (i < 2) {
+    dcollect(pid[i], o[i * 2], d[i * 2], b + i, n + i, h + i, si + i);
+    // The `exit(...)` line, printed last, has the VM's own cycle count. // 最後印出的 `exit(...)` 行含有虛擬機自己的週期數
+    m[i] = n[i] - 5; while (m[i] >= 0 && memcmp(b[i] + m[i], "exit(", 5)) --m[i];
+    if (m[i] < 0) m[i] = n[i];
+    ++i;
+  }
+
+  fwrite(b[0], 1, n[0], stdout);
+  j = 0; while (j < m[0] && j < m[1] && b[0][j] == b[1][j]) ++j;
+  r = 1;
+  if (si[0].si_code != si[1].si_code || si[0].si_status != si[1].si_status)
+    printf("diff: stack VM ended with %s %d, register VM with %s %d\n",
+      si[0].si_code == CLD_EXITED ? "exit code" : "signal", si[0].si_status,
+      si[1].si_code == CLD_EXITED ? "exit code" : "signal", si[1].si_status);
+  else if (j < m[0] || j < m[1])
+    printf("diff: output differs at byte %d: \"%.20s\" vs \"%.20s\"\n", j, b[0] + j, b[1] + j);
+  else if (h[0] != h[1]) printf("diff: globals differ at exit\n");
+  else { printf("diff: same output, exit code and globals\n"); r = 0; }
+  free(b[0]); free(b[1]);
+  return r;
+}
+#else
+// No sockets for c4 itself. // c4 本身沒有 socket
+int serve(char *path, char ***av)
+{
+  printf("--serve is only supported by host builds\n"); return -1;
+}
+
+// No processes for c4 itself. // c4 本身沒有行程
+int differ()
+{
+  printf("--diff is only supported by host builds\n"); return 1;
+}
+#endif
+
+// Clear the compiler and VM context for a new program. The caller's // 為新程式清除編譯器和虛擬機上下文
+// `alist` is kept. // 呼叫者的 `alist` 會保留
+void reset()
+{
+  p = lp = sbuf = data = dbase = dlim = 0;
+  e = le = text = tlim = id = li = tcall = fent = brks = swb = swd = swp = swlim = sym = symend = symlim = shadow = shp = slim = lnt = lnp = lmark = 0;
+  symidx = 0; laddr = nbrk = symmask = nlook = nprobe = ntok = tk = ival = ty = loc = line = 0;
+  pmap = pins = 0; ptgt = pjt = 0;
+  itext = idep = ifix = iloc = 0; imap = 0; iend = iarg = 0;
+  obuf = op = olim = 0;
+  hbase = hp = hlim = 0; hfl = 0;
+  popc = pfn = plist = pstk = pcnt = psp = 0; pn = 0;
+  rtext = re = rlim = rhalt = rdst = rend = rfix = rfp = rdep = vk = vv = 0; rmap = 0; rlab = 0;
+  vd = ak = av = rloc = rmax = 0;
+}
+
+// Compile and run the program in source code file or bytecode image // 編譯並執行原始碼檔案或位元組碼映像 `argv[0]` 中的程式,
+// `argv[0]`, passing it `argc` and `argv`. Return its exit code. // 並傳給它 `argc` 和 `argv`. 回傳其離開代碼
+int run(int argc, char **argv)
+{
+  int fd, bt, ty, *idmain;
+  int *pc, *sp, *bp, a, cycle; // vm registers // 虛擬機暫存器
+  int i, *t, *d; // temps // 暫存變數
+
+  // Start from an empty context. // 從空的上下文開始
+  reset();
+
+  // Open source code file. // 開啟原始碼檔案
+  // If failed, print error and exit program. // 若失敗則印出錯誤訊息並結束
+  if ((fd = open(*argv, 0)) < 0) { printf("could not open(%s)\n", *argv); return -1; }
+
+  // Reserve the areas, each between two guard pages. Nothing is zeroed // 保留各區域, 每個區域都位於兩個保護頁之間
+  // up front, and overflow stops with an error: `next` checks the text, // 不需要事先清零, 而溢位會以錯誤停止: `next` 檢查程式碼、
+  // data and symbol limits below, and `ENT` checks `slim`. // 資料和符號表上限, 而 `ENT` 檢查 `slim`
+  symend = sym = (int *)arena(ysz, "symbol");
+  symlim = sym + ysz / sizeof(int) - Idsz;
+  shp = shadow = (int *)arena(ysz, "shadow");
+  text = le = e = (int *)arena(tsz, "text");
+  lnp = lnt = (int *)arena(tsz * 2, "line table"); lmark = text;
+  swp = (int *)arena(tsz, "switch"); swlim = swp + tsz / sizeof(int) - 2;
+  tlim = text + tsz / sizeof(int) - 1024;
+  dbase = data = arena(dsz, "data");
+  dlim = data + dsz - 64;
+  sp = (int *)arena(ssz, "stack");
+  slim = sp + PGSZ / sizeof(int);
+  op = obuf = arena(osz + Onum, "output");
+  olim = obuf + osz;
+  if (heap) {
+    hp = hbase = arena(hsz, "heap"); hlim = hbase + hsz;
+    hfl = (int **)arena(Hcls * sizeof(int *), "heap");
+  }
+
+  // Reserve the symbol table's hash index with at least twice as many // 保留符號表的雜湊索引, 槽位數量至少是
+  // slots as the symbol table has entries. // 符號表條目數量的兩倍
+  symmask = 1; while (symmask < ysz / (Idsz * sizeof(int)) * 2) symmask = symmask * 2;
+  symidx = (int **)arena(symmask * sizeof(int *), "symbol index"); --symmask;
+
+  // Reserve the peephole optimizer's tables, sized for a function as // 保留窺孔最佳化器的表格,
+  // large as the text area. // 大小足以容納與程式碼區一樣大的函數
+  if (opt) {
+    pmap = (int **)arena(tsz, "optimizer"); pins = (int **)arena(tsz, "optimizer");
+    ptgt = arena(tsz / sizeof(int), "optimizer"); pjt = arena(tsz / sizeof(int), "optimizer");
+    itext = (int *)arena(tsz, "inliner"); imap = (int **)arena(tsz, "inliner");
+    idep = (int *)arena(tsz, "inliner"); ifix = (int *)arena(tsz, "inliner");
+    iloc = (int *)arena((Ibud + 2) * sizeof(int), "inliner");
+  }
+
+  // Reserve the register VM's code, at most four register code words per // 保留暫存器虛擬機的程式碼, 每個堆疊碼字組最多對應四個暫存器碼字組,
+  // stack code word, and its translation tables. // 以及其翻譯用的表格
+  if (regvm || diff) {
+    rtext = (int *)arena(tsz * 4, "register code"); rlim = rtext + tsz * 4 / sizeof(int) - 64;
+    rmap = (int **)arena(tsz, "register code"); rfix = (int *)arena(tsz * 2, "register code");
+    rdep = (int *)arena(tsz, "register code"); rlab = arena(tsz / sizeof(int), "register code");
+    vk = (int *)arena(ssz, "register code"); vv = (int *)arena(ssz, "register code");
+  }
+
+  // Reserve the profiler's counters: a set of fields per text word and a // 保留剖析器的計數器: 每個程式碼字組一組字段,
+  // call stack at least as deep as the VM stack allows. // 以及至少與虛擬機堆疊一樣深的呼叫堆疊
+  if (prof || lines) {
+    popc = (int *)arena((EXIT + 1) * sizeof(int), "profiler"); pfn = (int *)arena(tsz * Psz, "profiler");
+    plist = (int *)arena(tsz, "profiler"); psp = pstk = (int *)arena(ssz * 2, "profiler");
+    pcnt = (int *)arena(tsz, "profiler");
+  }
+
+  // Keywords and system call names. // 關鍵字與系統呼叫名稱
+  p = "break case char default else enum for if int return sizeof switch while "
+      "open read close printf malloc free memset memcmp memcpy memchr strlen strcmp strchr "
+      "mmap lseek write munmap fstat mreset exit void main";
+
+  // For each keyword from `break` to `while`, // 對每個關鍵字從 `break` 到 `while`
+  // call `next` to create symbol table entry, // 呼叫 `next` 建立符號表項目
+  // store the keyword's token type in the symbol table entry's `Tk` field. // 將 token 類型存入 `Tk` 欄位
+  i = Break; while (i <= While) { next(); id[Tk] = i++; } // add keywords to symbol table // 加入關鍵字至符號表
+
+  // For each system call name from `open` to `exit`, // 對每個系統呼叫從 `open` 到 `exit`
+  // call `next` to create symbol table entry, // 呼叫 `next` 建立符號表項目
+  // set the symbol table entry's symbol type field be `Sys`, // 將類型設為 `Sys`
+  // set the symbol table entry's associated value type field be the system // 將回傳型別設為整數
   // call's return type, // 系統呼叫的回傳型態
   // set the symbol table entry's associated value field be the system call's // 將系統呼叫的編號存入 `Val`
   // opcode. // 系統呼叫的操作碼
@@ -995,20 +3327,27 @@ int main(int argc, char **argv)
   // Point `idmain` to the symbol table entry. // 將 `idmain` 指向該項目
   next(); idmain = id; // keep track of main // 記錄 main 的位置
 
-  // Allocate source code buffer. // 配置原始碼區域
-  // If failed, print error and exit program. // 若失敗則印出錯誤訊息並結束
-  if (!(lp = p = malloc(poolsz))) { printf("could not malloc(%d) source area\n", poolsz); return -1; }
+  // Get the source code file's size. // 取得原始碼檔案的大小
+  // If failed or empty, print error and exit program. // 若失敗或為空則印出錯誤訊息並結束
+  if ((i = lseek(fd, 0, SEEK_END)) <= 0) { printf("lseek() returned %d\n", i); return -1; }
 
-  // Read source code from source code file into source code buffer. // 讀入原始碼至緩衝區
+  // Map the source code file read-only instead of copying it, so there is // 以唯讀方式映射原始碼檔案而不複製它
+  // no size limit. The file is mapped over the start of zero pages that // 所以沒有大小限制
+  // reach at least one byte past it, so the end maker `\0` that `next` // 檔案映射在至少超過其結尾一個位元組的零頁開頭,
+  // stops at always follows the last character. // 所以 `next` 停止所需的結尾符號 '\0' 總是緊接在最後一個字元之後
   // If failed, print error and exit program. // 若失敗則印出錯誤訊息並結束
-  if ((i = read(fd, p, poolsz-1)) <= 0) { printf("read() returned %d\n", i); return -1; }
-
-  // Add end maker `\0` after the source code in source code buffer. // 在最後補上字串結尾符號 '\0'
-  p[i] = 0;
+  if ((int)(sbuf = lp = p = mmap(0, (i + PGSZ) & -PGSZ, PROT_READ, MAP_ARENA, -1, 0)) == -1 ||
+      (int)mmap(p, i, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == -1) { printf("could not mmap(%s)\n", *argv); return -1; }
+  amap(sbuf, (i + PGSZ) & -PGSZ);
 
   // Close source code file. // 關閉原始碼檔案
   close(fd);
 
+  // If the file is a bytecode image written by `-o`, load it and set // 如果檔案是由 `-o` 寫出的位元組碼映像, 載入它並設定
+  // `main`'s address, and leave nothing for the parser below. There are // `main` 的位址, 下面的解析器則沒有東西可解析
+  // no source lines to map the code to. // 沒有原始碼行可以對應程式碼
+  if (*(int *)p == C4B) { idmain[Val] = (int)load((int *)p, i); lmark = e; lp = p = ""; }
+
   // parse declarations // 解析宣告
   line = 1;
 
@@ -1141,14 +3480,13 @@ int main(int argc, char **argv)
           // error and exit program. // 結束程式
           if (id[Class] == Loc) { printf("%d: duplicate parameter definition\n", line); return -1; }
 
-          // Back up the symbol's `Class`, `Type`, `Val` fields because they // 備份符號欄位
-          // will be used temporarily for the parameter name. // 這些欄位會暫時使用
+          // Save the symbol's `Class`, `Type`, `Val` fields on `shadow` // 將符號欄位備份到 `shadow`
+          // because they will be used temporarily for the parameter name. // 這些欄位會暫時使用
           // Set the symbol type be local variable. // 設為區域變數
           // Set the associated value type be the parameter's data type. // 設定參數型態
           // Store the parameter's index. // 儲存參數索引
-          id[HClass] = id[Class]; id[Class] = Loc;
-          id[HType]  = id[Type];  id[Type] = ty;
-          id[HVal]   = id[Val];   id[Val] = i++;
+          *shp++ = (int)id; *shp++ = id[Class]; *shp++ = id[Type]; *shp++ = id[Val];
+          id[Class] = Loc; id[Type] = ty; id[Val] = i++;
 
           // Read token. // 讀取下一個 token
           next();
@@ -1196,14 +3534,14 @@ int main(int argc, char **argv)
             // variable, print error and exit program. // 結束程式
             if (id[Class] == Loc) { printf("%d: duplicate local definition\n", line); return -1; }
 
-            // Back up the symbol's `Class`, `Type`, `Val` fields because they // 備份原本的欄位值
-            // will be used temporarily for the local variable name. // 這些欄位會被暫時覆寫
+            // Save the symbol's `Class`, `Type`, `Val` fields on `shadow` // 將原本的欄位值備份到 `shadow`
+            // because they will be used temporarily for the local variable // 這些欄位會被暫時覆寫
+            // name. // 給區域變數使用
             // Set the symbol type be local variable. // 設為區域變數
             // Set the associated value type be the local variable's data type. // 設定型態
             // Store the local variable's index. // 儲存變數偏移位置
-            id[HClass] = id[Class]; id[Class] = Loc;
-            id[HType]  = id[Type];  id[Type] = ty;
-            id[HVal]   = id[Val];   id[Val] = ++i;
+            *shp++ = (int)id; *shp++ = id[Class]; *shp++ = id[Type]; *shp++ = id[Val];
+            id[Class] = Loc; id[Type] = ty; id[Val] = ++i;
 
             // Read token. // 讀取下一個 token
             next();
@@ -1218,7 +3556,7 @@ int main(int argc, char **argv)
 
         // Add `ENT` instruction before function body. // 在函數主體前插入 `ENT` 指令
         // Add local variables count as operand. // 並插入區域變數數量
-        *++e = ENT; *++e = i - loc;
+        *++e = ENT; fent = t = e; *++e = i - loc; laddr = 0;
 
         // While current token is not function body's ending `}`, // 當不是 `}` 時
         // parse statement. // 解析語句
@@ -1227,22 +3565,21 @@ int main(int argc, char **argv)
         // Add `LEV` instruction after function body. // 在函數結尾插入 `LEV` 指令
         *++e = LEV;
 
-        // Point `id` to symbol table. // 回到符號表的起始
-        id = sym; // unwind symbol table locals // 還原符號表
-
-        // While current symbol table entry is in use. // 當前條目仍在使用中
-        while (id[Tk]) {
-          // If the symbol table entry is for function parameter or local
-          // variable. // 如果是參數或區域變數
-          if (id[Class] == Loc) {
-            // Restore `Class`, `Type` and `Val` fields' old value. // 還原原本的欄位值
-            id[Class] = id[HClass];
-            id[Type] = id[HType];
-            id[Val] = id[HVal];
-          }
-
-          // Point to next symbol table entry. // 移動到下一個條目
-          id = id + Idsz;
+        // A local's address taken below a tail call, such as in a loop, // 在尾呼叫之下 (例如在迴圈中) 取用的區域變數位址
+        // rules it out too: turn it back into a call. // 也排除尾呼叫: 將它變回一般呼叫
+        if (laddr) { d = t; while (d < e) { if (*d == TJSR) *d = JSR; d = d + (*d <= BGE ? 2 : 1); } }
+
+        // Run the peephole optimizer over the function's code. // 對函數的程式碼執行窺孔最佳化
+        if (opt) { peep(t); li = 0; }
+
+        // Unwind symbol table locals: pop the saved fields of each function // 還原符號表: 彈出每個參數或區域變數
+        // parameter or local variable off `shadow`. // 在 `shadow` 上的備份欄位
+        while (shp > shadow) {
+          // Restore `Class`, `Type` and `Val` fields' old value. // 還原原本的欄位值
+          shp = shp - 4; id = (int *)*shp;
+          id[Class] = shp[1];
+          id[Type] = shp[2];
+          id[Val] = shp[3];
         }
       }
       // If current token is not `(`, then it is not function definition, // 如果不是函數定義
@@ -1269,15 +3606,50 @@ int main(int argc, char **argv)
   // Point instruction pointer `pc` to `main` function's address. // 將指令指標 `pc` 指向 `main` 函數的位址
   // If symbol `main`'s `Val` field is not set, it means `main` function is
   // not defined, print error and exit program. // 如果 `main` 函數的 `Val` 欄位尚未設置，表示沒有定義 `main` 函數，印出錯誤訊息並退出
+  // Record the code of the last line, if it has no newline. // 記錄沒有換行的最後一行的程式碼
+  if (e > lmark) { *lnp++ = lmark + 1 - text; *lnp++ = line; lmark = e; }
+
+  // With `-O`, inline small leaf functions now that every function is known. // 使用 `-O` 時, 既然所有函數都已知, 內嵌展開小型葉函數
+  if (opt) inl();
+
   if (!(pc = (int *)idmain[Val])) { printf("main() not defined\n"); return -1; }
 
+  // Print front end and symbol table statistics. // 印出前端和符號表統計
+  if (stats && nlook) {
+    printf("tokens: %d, lines: %d, text: %d words, data: %d bytes\n", ntok, line - (p[-1] == '\n'), e - text, data - dbase);
+    printf("symbols: %d, lookups: %d, probes: %d (%d.%02d per lookup)\n",
+      (symend - sym) / Idsz, nlook, nprobe, nprobe / nlook, nprobe * 100 / nlook % 100);
+  }
+
+  // If `-o` is given, write the bytecode image and exit program. // 若指定 `-o`, 寫出位元組碼映像後結束程式
+  if (out) return save(out, pc);
+
   // If switch for printing source code line and corresponding instructions is
   // on, exit program. // 如果有開啟印出原始碼及對應指令的選項，則退出程式
   if (src) return 0;
 
   // setup stack // 設定堆疊
   // Point frame base pointer `bp` and stack top pointer `sp` to stack bottom. // 將基底指標 `bp` 和堆疊頂端 `sp` 指向堆疊底部
-  bp = sp = (int *)((int)sp + poolsz);
+  bp = sp = (int *)((int)sp + ssz);
+
+  // Translate the code for the register VM. // 為暫存器虛擬機翻譯程式碼
+  if (regvm || diff) rtrans(e);
+
+  // With `--serve`, wait for requests here; each continues below in a // 使用 `--serve` 時, 在這裡等待請求;
+  // child of its own, with the request's arguments. // 每個請求在自己的子行程中, 以請求的參數繼續執行下面的程式
+  if (sock && (argc = serve(sock, &argv)) < 0) return -1;
+
+  // If `-j` is given, run `main` as native code instead. // 若指定 `-j`, 改以原生機器碼執行 `main`
+  // Profiling needs the VM loop, so `-p` and `-l` win over `-j`. // 剖析需要虛擬機迴圈, 所以 `-p` 和 `-l` 優先於 `-j`
+  if (jit && !prof && !lines) return jitrun(text, e, pc, sp, argc, argv);
+
+  // With `--diff`, run the program on both VMs and compare; each continues // 使用 `--diff` 時, 在兩種虛擬機上執行程式並比較;
+  // below in a child of its own. // 每個虛擬機在自己的子行程中繼續執行下面的程式
+  if (diff && (i = differ()) >= 0) return i;
+
+  // If `-r` is given, run `main` on the register VM instead. // 若指定 `-r`, 改在暫存器虛擬機上執行 `main`
+  // Profiling needs the stack VM, so `-p` and `-l` win over `-r` too. // 剖析需要堆疊虛擬機, 所以 `-p` 和 `-l` 也優先於 `-r`
+  if (regvm && !prof && !lines) return rrun(rmap[pc - text], sp, argc, argv);
 
   // Push `EXIT` instruction to stack. // 將 `EXIT` 指令壓入堆疊
   // Note the stack grows towards lower address so after the `PSH` instruction
@@ -1304,6 +3676,112 @@ int main(int argc, char **argv)
   // run... // 開始執行虛擬機器指令
   // Instruction cycles count. // 指令執行的週期計數
   cycle = 0;
+
+#if defined(__GNUC__)
+  // Threaded dispatch (GNU C "labels as values"). // 串接式分派 (GNU C 的「標籤作為值」擴充)
+  // Every handler ends by jumping straight to the next opcode's handler // 每個處理程序結束時, 直接透過標籤位址表跳到下一個操作碼的處理程序
+  // through a table of label addresses, so an instruction costs one // 因此每個指令只需要一次間接跳躍
+  // indirect branch instead of walking the `if` chain below. The chain is // 而不必走過下面的 `if` 串列
+  // kept as the portable engine, and for `-d` which traces every // 該串列保留作為可攜式的執行引擎, 並供需要追蹤每個指令的 `-d` 模式使用
+  // instruction. c4 itself skips this block (see `next`). // c4 本身會跳過這個區塊 (見 `next`)
+  if (!debug) {
+    // Handler addresses, in opcode order. // 處理程序位址, 依操作碼順序排列
+    static void *optab[] = {
+      &&op_LEA, &&op_IMM, &&op_JMP, &&op_JSR, &&op_BZ,  &&op_BNZ, &&op_ENT, &&op_ADJ, &&op_TJSR, &&op_JTAB,
+      &&op_LLI, &&op_SLI, &&op_LGI, &&op_SGI, &&op_ADDI, &&op_BEQ, &&op_BNE, &&op_BLT, &&op_BGT, &&op_BLE, &&op_BGE,
+      &&op_LEV, &&op_LI,  &&op_LC,  &&op_SI,  &&op_SC,  &&op_PSH,
+      &&op_OR,  &&op_XOR, &&op_AND, &&op_EQ,  &&op_NE,  &&op_LT,  &&op_GT,  &&op_LE,  &&op_GE,  &&op_SHL, &&op_SHR, &&op_ADD, &&op_SUB, &&op_MUL, &&op_DIV, &&op_MOD,
+      &&op_OPEN, &&op_READ, &&op_CLOS, &&op_PRTF, &&op_MALC, &&op_FREE, &&op_MSET, &&op_MCMP,
+      &&op_MCPY, &&op_MCHR, &&op_SLEN, &&op_SCMP, &&op_SCHR, &&op_MMAP, &&op_LSEK, &&op_WRIT, &&op_MUNM, &&op_FSTA, &&op_MRST, &&op_EXIT };
+    // With `-p` or `-l`, dispatch through a table that sends every opcode to // 使用 `-p` 或 `-l` 時, 透過一個將所有操作碼送到 `op_PROF` 的表格分派,
+    // `op_PROF` first, so the normal path pays nothing for profiling. // 所以一般路徑不需為剖析付出任何代價
+    void *proftab[EXIT + 1], **ops;
+
+    i = 0; while (i <= EXIT) proftab[i++] = &&op_PROF;
+    ops = (prof || lines) ? proftab : optab;
+
+    // Fetch the next instruction, count the cycle and jump to its handler. // 取得下一個指令, 計算週期並跳到其處理程序
+#define NEXT ++cycle; goto *ops[*pc++]
+
+    NEXT;
+
+    // Count the instruction, then run its handler. // 計算指令次數, 然後執行其處理程序
+    // Only words in the text segment count for `-l`, not the `PSH; EXIT` // `-l` 只計算程式碼段中的字組,
+    // on the stack. // 不計算堆疊上的 `PSH; EXIT`
+    op_PROF: ++popc[pc[-1]]; if (lines && pc > text && pc <= e + 1) ++pcnt[pc - 1 - text]; goto *optab[pc[-1]];
+
+    // Same semantics as the `if` chain below. // 語意與下面的 `if` 串列相同
+    op_LEA: a = (int)(bp + *pc++);                             NEXT;
+    op_IMM: a = *pc++;                                         NEXT;
+    op_JMP: pc = (int *)*pc;                                   NEXT;
+    op_JSR: *--sp = (int)(pc + 1); pc = (int *)*pc;            NEXT;
+    op_BZ:  pc = a ? pc + 1 : (int *)*pc;                      NEXT;
+    op_BNZ: pc = a ? (int *)*pc : pc + 1;                      NEXT;
+    op_ENT: *--sp = (int)bp; bp = sp; sp = sp - *pc++; if (prof) penter(pc - 2, cycle);
+            if (sp < slim) { oflush(); printf("stack overflow\n"); return -1; } NEXT;
+    op_ADJ: sp = sp + *pc++;                                   NEXT;
+    op_TJSR: if (prof) pleave(cycle);
+            i = (pc[1] == ADJ) ? pc[2] : 0; while (i) { --i; bp[i + 2] = sp[i]; }
+            sp = bp + 1; bp = (int *)*bp; pc = (int *)*pc;     NEXT;
+    op_JTAB: pc = (int *)pc[(a >= 0 && a < *pc) ? a * 2 + 2 : *pc * 2 + 2]; NEXT;
+    op_LLI: a = bp[*pc++];                                     NEXT;
+    op_SLI: bp[*pc++] = a;                                     NEXT;
+    op_LGI: a = *(int *)*pc++;                                 NEXT;
+    op_SGI: *(int *)*pc++ = a;                                 NEXT;
+    op_ADDI: a = a + *pc++;                                    NEXT;
+    op_BEQ: pc = *sp++ == a ? (int *)*pc : pc + 1;             NEXT;
+    op_BNE: pc = *sp++ != a ? (int *)*pc : pc + 1;             NEXT;
+    op_BLT: pc = *sp++ <  a ? (int *)*pc : pc + 1;             NEXT;
+    op_BGT: pc = *sp++ >  a ? (int *)*pc : pc + 1;             NEXT;
+    op_BLE: pc = *sp++ <= a ? (int *)*pc : pc + 1;             NEXT;
+    op_BGE: pc = *sp++ >= a ? (int *)*pc : pc + 1;             NEXT;
+    op_LEV: if (prof) pleave(cycle);
+            sp = bp; bp = (int *)*sp++; pc = (int *)*sp++;     NEXT;
+    op_LI:  a = *(int *)a;                                     NEXT;
+    op_LC:  a = *(char *)a;                                    NEXT;
+    op_SI:  *(int *)*sp++ = a;                                 NEXT;
+    op_SC:  a = *(char *)*sp++ = a;                            NEXT;
+    op_PSH: *--sp = a;                                         NEXT;
+    op_OR:  a = *sp++ |  a;                                    NEXT;
+    op_XOR: a = *sp++ ^  a;                                    NEXT;
+    op_AND: a = *sp++ &  a;                                    NEXT;
+    op_EQ:  a = *sp++ == a;                                    NEXT;
+    op_NE:  a = *sp++ != a;                                    NEXT;
+    op_LT:  a = *sp++ <  a;                                    NEXT;
+    op_GT:  a = *sp++ >  a;                                    NEXT;
+    op_LE:  a = *sp++ <= a;                                    NEXT;
+    op_GE:  a = *sp++ >= a;                                    NEXT;
+    op_SHL: a = *sp++ << a;                                    NEXT;
+    op_SHR: a = *sp++ >> a;                                    NEXT;
+    op_ADD: a = *sp++ +  a;                                    NEXT;
+    op_SUB: a = *sp++ -  a;                                    NEXT;
+    op_MUL: a = *sp++ *  a;                                    NEXT;
+    op_DIV: a = *sp++ /  a;                                    NEXT;
+    op_MOD: a = *sp++ %  a;                                    NEXT;
+    op_OPEN: t = sp + pc[1]; a = open((char *)t[-1], t[-2], t[-3]); NEXT;
+    op_READ: a = oread(sp[2], (char *)sp[1], *sp);             NEXT;
+    op_CLOS: a = close(*sp);                                   NEXT;
+    op_PRTF: a = oprintf(sp + pc[1], pc[1]);                    NEXT;
+    op_MALC: a = (int)gmalloc(*sp);                            NEXT;
+    op_FREE: gfree((char *)*sp);                               NEXT;
+    op_MSET: a = (int)memset((char *)sp[2], sp[1], *sp);       NEXT;
+    op_MCMP: a = memcmp((char *)sp[2], (char *)sp[1], *sp);    NEXT;
+    op_MCPY: a = (int)memcpy((char *)sp[2], (char *)sp[1], *sp); NEXT;
+    op_MCHR: a = (int)memchr((char *)sp[2], sp[1], *sp);       NEXT;
+    op_SLEN: a = strlen((char *)*sp);                          NEXT;
+    op_SCMP: a = strcmp((char *)sp[1], (char *)*sp);           NEXT;
+    op_SCHR: a = (int)strchr((char *)sp[1], *sp);              NEXT;
+    op_MMAP: a = (int)mmap((char *)sp[5], sp[4], sp[3], sp[2], sp[1], *sp); NEXT;
+    op_LSEK: a = lseek(sp[2], sp[1], *sp);                     NEXT;
+    op_MUNM: a = munmap((char *)sp[1], *sp);                   NEXT;
+    op_FSTA: a = fstat(sp[1], (void *)*sp);             NEXT;
+    op_MRST: a = greset();                                     NEXT;
+    op_WRIT: a = owrite(sp[2], (char *)sp[1], *sp);            NEXT;
+    op_EXIT: oflush(); printf("exit(%d) cycle = %d\n", *sp, cycle); if (prof) pdump(cycle); if (lines) ldump(cycle); return *sp;
+#undef NEXT
+  }
+#endif
+
   // Run VM loop to execute VM instructions. // 執行虛擬機器迴圈以執行指令
   while (1) {
     // Get current instruction. // 取得當前指令
@@ -1311,75 +3789,116 @@ int main(int argc, char **argv)
     // Increment instruction cycles count. // 增加執行週期計數
     i = *pc++; ++cycle;
 
+    // Count the instruction for `-p` and `-l`. // 為 `-p` 和 `-l` 計算指令次數
+    if (prof) ++popc[i];
+    if (lines && pc > text && pc <= e + 1) ++pcnt[pc - 1 - text];
+
     // If debug switch is on. // 如果開啟除錯模式
     if (debug) {
       // Print opcode. // 印出操作碼
-      printf("%d> %.4s", cycle,
-        &"LEA ,IMM ,JMP ,JSR ,BZ  ,BNZ ,ENT ,ADJ ,LEV ,LI  ,LC  ,SI  ,SC  ,PSH ,"
-         "OR  ,XOR ,AND ,EQ  ,NE  ,LT  ,GT  ,LE  ,GE  ,SHL ,SHR ,ADD ,SUB ,MUL ,DIV ,MOD ,"
-         "OPEN,READ,CLOS,PRTF,MALC,FREE,MSET,MCMP,EXIT,"[i * 5]);
+      printf("%d> %.4s", cycle, &opname[i * 5]);
 
-      // If the opcode <= ADJ, it has operand. // 如果操作碼小於等於 ADJ，表示它有運算元
+      // If the opcode <= BGE, it has operand. // 如果操作碼小於等於 BGE，表示它有運算元
       // Print operand. // 印出運算元
-      if (i <= ADJ) printf(" %d\n", *pc); else printf("\n");
+      if (i <= BGE) printf(" %d\n", *pc); else printf("\n");
     }
 
+    // Run the instruction; c4 compiles this dispatch to a jump table. // 執行指令; c4 將這個分派編譯成跳躍表
+    switch (i) {
     // Add the base address in frame base pointer `bp` to the offset in the
     // operand. // 將基底指標 `bp` 加上運算元中的偏移量
-    if      (i == LEA) a = (int)(bp + *pc++);                             // load local address // 載入區域變數位址
+    case LEA: a = (int)(bp + *pc++); break;                               // load local address // 載入區域變數位址
     // Load the operand to register. // 將運算元載入到暫存器
-    else if (i == IMM) a = *pc++;                                         // load global address or immediate // 載入全域變數位址或立即值
+    case IMM: a = *pc++; break;                                           // load global address or immediate // 載入全域變數位址或立即值
     // Jump to the address in the operand. // 跳到運算元中的位址
-    else if (i == JMP) pc = (int *)*pc;                                   // jump // 無條件跳躍
+    case JMP: pc = (int *)*pc; break;                                     // jump // 無條件跳躍
     // Push the return address in the second operand to stack. // 將返回位址推入堆疊
     // Jump to the address in the first operand. // 跳到第一個運算元位址
-    else if (i == JSR) { *--sp = (int)(pc + 1); pc = (int *)*pc; }        // jump to subroutine // 呼叫子程式
+    case JSR: *--sp = (int)(pc + 1); pc = (int *)*pc; break;              // jump to subroutine // 呼叫子程式
     // Jump to the address in the first operand if register value is 0. // 如果暫存器值為 0 則跳躍
-    else if (i == BZ)  pc = a ? pc + 1 : (int *)*pc;                      // branch if zero // 為零則跳
+    case BZ: pc = a ? pc + 1 : (int *)*pc; break;                         // branch if zero // 為零則跳
     // Jump to the address in the first operand if register value is not 0. // 如果暫存器值不為 0 則跳躍
-    else if (i == BNZ) pc = a ? (int *)*pc : pc + 1;                      // branch if not zero // 不為零則跳
+    case BNZ: pc = a ? (int *)*pc : pc + 1; break;                        // branch if not zero // 不為零則跳
     // Push the caller's frame base address in `bp` to stack. // 將目前函數的基底指標 `bp` 推入堆疊
     // Point `bp` to stack top for the callee. // 設定新函數的基底指標為目前堆疊頂
     // Decrease stack top pointer `sp` by the value in the operand to reserve // 將堆疊頂 `sp` 減去運算元值以保留區域變數空間
     // space for the callee's local variables. // 為子函數的區域變數保留空間
-    else if (i == ENT) { *--sp = (int)bp; bp = sp; sp = sp - *pc++; }     // enter subroutine // 進入子程式
+    case ENT:                                                             // enter subroutine // 進入子程式
+      *--sp = (int)bp; bp = sp; sp = sp - *pc++;
+      // Stop cleanly before running into the stack's guard page. // 在碰到堆疊的保護頁之前正常停止
+      if (sp < slim) { oflush(); printf("stack overflow\n"); return -1; }
+      if (prof) penter(pc - 2, cycle);
+      break;
     // Pop arguments off stack after returning from function call. // 函數呼叫返回後從堆疊中移除參數
-    else if (i == ADJ) sp = sp + *pc++;                                   // stack adjust // 調整堆疊
+    case ADJ: sp = sp + *pc++; break;                                     // stack adjust // 調整堆疊
+    // Move the arguments of the `ADJ` that follows over the current // 將其後 `ADJ` 的參數移到目前函數的參數上,
+    // function's, drop its frame, keeping its return address, and jump. // 丟棄其框架但保留其返回位址, 然後跳躍
+    case TJSR:                                                            // tail call // 尾呼叫
+      if (prof) pleave(cycle);
+      i = (pc[1] == ADJ) ? pc[2] : 0; while (i) { --i; bp[i + 2] = sp[i]; }
+      sp = bp + 1; bp = (int *)*bp; pc = (int *)*pc;
+      break;
+    // Jump to the target of the `a`th `JMP` of the table that follows, or // 跳到其後表格中第 `a` 個 `JMP` 的目標,
+    // of its last one if `a` is out of range. // 若 `a` 超出範圍則跳到最後一個的目標
+    case JTAB: pc = (int *)pc[(a >= 0 && a < *pc) ? a * 2 + 2 : *pc * 2 + 2]; break;   // jump table // 跳躍表
+
+    // The following instructions are superinstructions. // 以下是超級指令
+    // Load int value of the local variable at offset in the operand. // 載入運算元中偏移量的區域變數的整數值
+    case LLI: a = bp[*pc++]; break;                                       // load local int // 載入區域整數
+    // Save int value in register to the local variable. // 將暫存器中的整數存入區域變數
+    case SLI: bp[*pc++] = a; break;                                       // store local int // 儲存區域整數
+    // Load int value of the global variable at the address in the operand. // 載入運算元中位址的全域變數的整數值
+    case LGI: a = *(int *)*pc++; break;                                   // load global int // 載入全域整數
+    // Save int value in register to the global variable. // 將暫存器中的整數存入全域變數
+    case SGI: *(int *)*pc++ = a; break;                                   // store global int // 儲存全域整數
+    // Add the operand to register. // 將運算元加到暫存器
+    case ADDI: a = a + *pc++; break;                                      // add immediate // 加上立即值
+    // Compare value on stack with register value, jump to the address in // 比較堆疊中的值與暫存器值
+    // the operand if the comparison is true. // 若比較結果為真則跳到運算元中的位址
+    case BEQ: pc = *sp++ == a ? (int *)*pc : pc + 1; break;               // branch if equal // 等於則跳
+    case BNE: pc = *sp++ != a ? (int *)*pc : pc + 1; break;               // branch if not equal // 不等於則跳
+    case BLT: pc = *sp++ <  a ? (int *)*pc : pc + 1; break;               // branch if less // 小於則跳
+    case BGT: pc = *sp++ >  a ? (int *)*pc : pc + 1; break;               // branch if greater // 大於則跳
+    case BLE: pc = *sp++ <= a ? (int *)*pc : pc + 1; break;               // branch if less or equal // 小於等於則跳
+    case BGE: pc = *sp++ >= a ? (int *)*pc : pc + 1; break;               // branch if greater or equal // 大於等於則跳
     // Point stack top pointer `sp` to caller's stack top before the call. // 將堆疊頂回復為呼叫者狀態
     // Pop caller's frame base address off stack into `bp`. // 從堆疊取出呼叫者的 `bp`
     // The old value was pushed to stack by `ENT` instruction. // 這是由 `ENT` 指令儲存的
-    else if (i == LEV) { sp = bp; bp = (int *)*sp++; pc = (int *)*sp++; } // leave subroutine // 離開子程式
+    case LEV:                                                             // leave subroutine // 離開子程式
+      if (prof) pleave(cycle);
+      sp = bp; bp = (int *)*sp++; pc = (int *)*sp++;
+      break;
     // Load int value on the address in register to register. // 將暫存器中位址對應的 int 值載入
-    else if (i == LI)  a = *(int *)a;                                     // load int // 載入整數
+    case LI: a = *(int *)a; break;                                        // load int // 載入整數
     // Load char value on the address in register to register. // 將暫存器中位址對應的 char 值載入
-    else if (i == LC)  a = *(char *)a;                                    // load char // 載入字元
+    case LC: a = *(char *)a; break;                                       // load char // 載入字元
     // Save int value in register to address on stack. // 將暫存器中的整數存入堆疊位址
-    else if (i == SI)  *(int *)*sp++ = a;                                 // store int // 儲存整數
+    case SI: *(int *)*sp++ = a; break;                                    // store int // 儲存整數
     // Save char value in register to address on stack. // 將暫存器中的字元存入堆疊位址
-    else if (i == SC)  a = *(char *)*sp++ = a;                            // store char // 儲存字元
+    case SC: a = *(char *)*sp++ = a; break;                               // store char // 儲存字元
     // Push register value to stack. // 將暫存器值推入堆疊
-    else if (i == PSH) *--sp = a;                                         // push // 推入堆疊
+    case PSH: *--sp = a; break;                                           // push // 推入堆疊
 
     // The following instructions take two arguments. // 以下指令需要兩個參數
     // The first argument is on stack. // 第一個參數在堆疊中
     // The second argument is in register. // 第二個參數在暫存器中
     // The result is put to register. // 結果寫入暫存器
-    else if (i == OR)  a = *sp++ |  a; // OR // 位元或
-    else if (i == XOR) a = *sp++ ^  a; // XOR // 位元異或
-    else if (i == AND) a = *sp++ &  a; // AND // 位元與
-    else if (i == EQ)  a = *sp++ == a; // EQ // 等於
-    else if (i == NE)  a = *sp++ != a; // NE // 不等於
-    else if (i == LT)  a = *sp++ <  a; // LT // 小於
-    else if (i == GT)  a = *sp++ >  a; // GT // 大於
-    else if (i == LE)  a = *sp++ <= a; // LE // 小於等於
-    else if (i == GE)  a = *sp++ >= a; // GE // 大於等於
-    else if (i == SHL) a = *sp++ << a; // SHL // 左移
-    else if (i == SHR) a = *sp++ >> a; // SHR // 右移
-    else if (i == ADD) a = *sp++ +  a; // ADD // 加法
-    else if (i == SUB) a = *sp++ -  a; // SUB // 減法
-    else if (i == MUL) a = *sp++ *  a; // MUL // 乘法
-    else if (i == DIV) a = *sp++ /  a; // DIV // 除法
-    else if (i == MOD) a = *sp++ %  a; // MOD // 取餘數
+    case OR: a = *sp++ |  a; break;    // OR // 位元或
+    case XOR: a = *sp++ ^  a; break;   // XOR // 位元異或
+    case AND: a = *sp++ &  a; break;   // AND // 位元與
+    case EQ: a = *sp++ == a; break;    // EQ // 等於
+    case NE: a = *sp++ != a; break;    // NE // 不等於
+    case LT: a = *sp++ <  a; break;    // LT // 小於
+    case GT: a = *sp++ >  a; break;    // GT // 大於
+    case LE: a = *sp++ <= a; break;    // LE // 小於等於
+    case GE: a = *sp++ >= a; break;    // GE // 大於等於
+    case SHL: a = *sp++ << a; break;   // SHL // 左移
+    case SHR: a = *sp++ >> a; break;   // SHR // 右移
+    case ADD: a = *sp++ +  a; break;   // ADD // 加法
+    case SUB: a = *sp++ -  a; break;   // SUB // 減法
+    case MUL: a = *sp++ *  a; break;   // MUL // 乘法
+    case DIV: a = *sp++ /  a; break;   // DIV // 除法
+    case MOD: a = *sp++ %  a; break;   // MOD // 取餘數
 
     // The following instructions are system calls. // 以下是系統呼叫指令
     // They take arguments from stack, just like a user-defined function does. // 他們從堆疊中取得參數，就像使用者自定函數一樣
@@ -1392,42 +3911,312 @@ int main(int argc, char **argv)
     // Open file. // 開啟檔案
     // Arg 1: The file path to open. // 參數 1：檔案路徑
     // Arg 2: The flags. // 參數 2：開啟模式
-    else if (i == OPEN) a = open((char *)sp[1], *sp);
+    // Arg 3: The permissions of a created file, optional, so like `PRTF` // 參數 3：建立檔案的權限, 可省略,
+    // below the arguments are found through the following `ADJ`. // 所以與下面的 `PRTF` 一樣透過後面的 `ADJ` 找到參數
+    case OPEN: t = sp + pc[1]; a = open((char *)t[-1], t[-2], t[-3]); break;
     // Read from file descriptor into buffer. // 從檔案描述符讀取資料到緩衝區
     // Arg 1: The file descriptor. // 參數 1：檔案描述符
     // Arg 2: The buffer pointer. // 參數 2：緩衝區指標
     // Arg 3: The number of bytes to read. // 參數 3：要讀取的位元組數
-    else if (i == READ) a = read(sp[2], (char *)sp[1], *sp);
+    case READ: a = oread(sp[2], (char *)sp[1], *sp); break;
     // Close file descriptor. // 關閉檔案
     // Arg 1: The file descriptor. // 參數 1：檔案描述符
-    else if (i == CLOS) a = close(*sp);
+    case CLOS: a = close(*sp); break;
     // Print formatted string. // 印出格式化字串
     // Because the call has arguments, an ADJ instruction should have been
     // added. `pc[1]` gets the ADJ instruction's operand, i.e. the number of
     // arguments. // 因為該呼叫有參數，所以前面應有 ADJ 指令，`pc[1]` 是該 ADJ 的參數數量
     // Arg 1: The format string. // 參數 1：格式字串
-    // Arg 2-7: The formatted values. // 參數 2-7：對應格式字串的值
-    else if (i == PRTF) { t = sp + pc[1]; a = printf((char *)t[-1], t[-2], t[-3], t[-4], t[-5], t[-6]); }
+    // Arg 2-: The formatted values, as many as were passed. // 參數 2 起：對應格式字串的值, 傳入多少就有多少
+    case PRTF: a = oprintf(sp + pc[1], pc[1]); break;
     // Allocate memory block. // 配置記憶體區塊
     // Arg 1: The number of bytes to allocate. // 參數 1：要配置的位元組數
-    else if (i == MALC) a = (int)malloc(*sp);
+    case MALC: a = (int)gmalloc(*sp); break;
     // Free memory block allocated. // 釋放記憶體區塊
     // Arg 1: The memory block pointer. // 參數 1：記憶體區塊的指標
-    else if (i == FREE) free((void *)*sp);
+    case FREE: gfree((char *)*sp); break;
     // Set every byte in a memory buffer to the same value. // 將記憶體中的每個位元組設為同一數值
     // Arg 1: The buffer pointer. // 參數 1：緩衝區位址
     // Arg 2: The value. // 參數 2：欲填入的值
     // Arg 3: The number of bytes to set. // 參數 3：欲設定的位元組數
-    else if (i == MSET) a = (int)memset((char *)sp[2], sp[1], *sp);
+    case MSET: a = (int)memset((char *)sp[2], sp[1], *sp); break;
     // Compare memory buffer. // 比較兩段記憶體內容
     // Arg 1: The first buffer pointer. // 參數 1：第一段記憶體
     // Arg 2: The second buffer pointer. // 參數 2：第二段記憶體
     // Arg 3: The number of bytes to compare. // 參數 3：比較的位元組數
-    else if (i == MCMP) a = memcmp((char *)sp[2], (char *)sp[1], *sp);
+    case MCMP: a = memcmp((char *)sp[2], (char *)sp[1], *sp); break;
+    // The string and memory routines below are the host's, which scan and // 以下的字串和記憶體函式是主機的,
+    // copy many bytes per step, where guest loops go a byte per `LC`/`SC`. // 每步掃描和複製多個位元組, 而客體的迴圈每個 `LC`/`SC` 只處理一個位元組
+    // Copy a memory buffer that does not overlap the destination. // 複製與目的地不重疊的記憶體
+    // Arg 1: The destination pointer. // 參數 1：目的地位址
+    // Arg 2: The source pointer. // 參數 2：來源位址
+    // Arg 3: The number of bytes to copy. // 參數 3：複製的位元組數
+    case MCPY: a = (int)memcpy((char *)sp[2], (char *)sp[1], *sp); break;
+    // Find the first byte of a memory buffer with a value, or 0. // 找出記憶體中第一個等於某數值的位元組, 或 0
+    // Arg 1: The buffer pointer. // 參數 1：緩衝區位址
+    // Arg 2: The value. // 參數 2：欲尋找的值
+    // Arg 3: The number of bytes to search. // 參數 3：搜尋的位元組數
+    case MCHR: a = (int)memchr((char *)sp[2], sp[1], *sp); break;
+    // Get the length of a string. // 取得字串的長度
+    // Arg 1: The string. // 參數 1：字串
+    case SLEN: a = strlen((char *)*sp); break;
+    // Compare two strings. // 比較兩個字串
+    // Arg 1: The first string. // 參數 1：第一個字串
+    // Arg 2: The second string. // 參數 2：第二個字串
+    case SCMP: a = strcmp((char *)sp[1], (char *)*sp); break;
+    // Find the first character of a string with a value, or 0. // 找出字串中第一個等於某數值的字元, 或 0
+    // Arg 1: The string. // 參數 1：字串
+    // Arg 2: The value; 0 finds the string's end. // 參數 2：欲尋找的值; 0 會找到字串的結尾
+    case SCHR: a = (int)strchr((char *)sp[1], *sp); break;
+    // Map memory pages. // 映射記憶體分頁
+    // Arg 1: The address hint. // 參數 1：建議位址
+    // Arg 2: The number of bytes to map. // 參數 2：映射的位元組數
+    // Arg 3: The protection. // 參數 3：保護模式
+    // Arg 4: The flags. // 參數 4：旗標
+    // Arg 5: The file descriptor. // 參數 5：檔案描述符
+    // Arg 6: The file offset. // 參數 6：檔案位移
+    case MMAP: a = (int)mmap((char *)sp[5], sp[4], sp[3], sp[2], sp[1], *sp); break;
+    // Move a file's read/write offset. // 移動檔案的讀寫位移
+    // Arg 1: The file descriptor. // 參數 1：檔案描述符
+    // Arg 2: The offset. // 參數 2：位移
+    // Arg 3: Where the offset counts from. // 參數 3：位移的起點
+    case LSEK: a = lseek(sp[2], sp[1], *sp); break;
+    // Unmap memory pages. // 解除記憶體分頁的映射
+    // Arg 1: The address. // 參數 1：位址
+    // Arg 2: The number of bytes to unmap. // 參數 2：解除映射的位元組數
+    case MUNM: a = munmap((char *)sp[1], *sp); break;
+    // Get a file's status, such as its size. // 取得檔案的狀態, 例如大小
+    // Arg 1: The file descriptor. // 參數 1：檔案描述符
+    // Arg 2: A buffer for the host's `struct stat`, 144 bytes on x86-64 // 參數 2：主機 `struct stat` 的緩衝區, 在 x86-64 Linux 上為 144 位元組,
+    // Linux, where the size is word 6. // 其中大小是第 6 個字組
+    case FSTA: a = fstat(sp[1], (void *)*sp); break;
+    // Free every block allocated so far, with `-m`. // 使用 `-m` 時, 釋放到目前為止配置的所有區塊
+    case MRST: a = greset(); break;
+    // Write buffer to file descriptor. // 將緩衝區寫入檔案描述符
+    // Arg 1: The file descriptor. // 參數 1：檔案描述符
+    // Arg 2: The buffer pointer. // 參數 2：緩衝區指標
+    // Arg 3: The number of bytes to write. // 參數 3：要寫入的位元組數
+    case WRIT: a = owrite(sp[2], (char *)sp[1], *sp); break;
     // Exit program. // 結束程式
     // Arg 1: The exit code. // 參數 1：離開代碼
-    else if (i == EXIT) { printf("exit(%d) cycle = %d\n", *sp, cycle); return *sp; }
+    case EXIT: oflush(); printf("exit(%d) cycle = %d\n", *sp, cycle); if (prof) pdump(cycle); if (lines) ldump(cycle); return *sp;
     // Current instruction is unknown, print error and exit program. // 不明指令，印出錯誤並結束
-    else { printf("unknown instruction = %d! cycle = %d\n", i, cycle); return -1; }
+    default: oflush(); printf("unknown instruction = %d! cycle = %d\n", i, cycle); return -1;
+    }
+  }
+}
+
+#if defined(__GNUC__)
+// `--batch`: run many programs in one process, without a fork and exec // `--batch`: 在一個行程中執行許多程式, 不需要每個程式各一次 fork 和 exec
+// each. Each line of the job file is a program and its arguments separated // 工作檔案的每一行是一個程式和其參數, 以空白分隔;
+// by blanks; empty lines and lines starting with `#` are skipped. Each of // 空行和以 `#` 開頭的行會被跳過
+// `nthread` workers owns a queue that starts with an equal share of the // `nthread` 個工作執行緒各擁有一個佇列, 一開始平分所有工作.
+// jobs. A worker takes jobs from the back of its own queue, and once that // 工作執行緒從自己佇列的尾端取工作,
+// is empty it steals from the front of the others', so a few long jobs do // 自己的佇列空了之後, 再從其他佇列的前端偷取工作,
+// not leave cores idle. Each job runs in its worker's context, and its // 所以少數長時間的工作不會讓核心閒置. 每個工作在其工作執行緒的上下文中執行,
+// areas are unmapped when it ends. Jobs share standard output and file // 工作結束時會解除其區域的映射
+// descriptors. // 工作共用標準輸出和檔案描述符
+
+char ***bargv;        // arguments of each job // 每個工作的參數
+int *bargc,           // argument count of each job // 每個工作的參數數量
+    *bcode,           // exit code of each job // 每個工作的離開代碼
+    *qlo, *qhi;       // queue of each worker: jobs `qlo[w]` .. `qhi[w] - 1` // 每個工作執行緒的佇列: 工作 `qlo[w]` .. `qhi[w] - 1`
+pthread_mutex_t *qmu; // lock of each queue // 每個佇列的鎖
+
+// Take a job for worker `w`: the last of its own queue, or else the first // 為工作執行緒 `w` 取一個工作: 自己佇列的最後一個,
+// of another worker's. Return -1 when every queue is empty. // 否則是其他工作執行緒佇列的第一個. 所有佇列都空時回傳 -1
+int take(int w)
+{
+  int v, q, j;
+
+  j = -1; v = 0;
+  while (j < 0 && v < nthread) {
+    q = (w + v) % nthread;
+    pthread_mutex_lock(qmu + q);
+    if (qlo[q] < qhi[q]) j = v ? qlo[q]++ : --qhi[q];
+    pthread_mutex_unlock(qmu + q);
+    ++v;
+  }
+  return j;
+}
+
+// Run jobs on worker `w` until none are left. // 在工作執行緒 `w` 上執行工作直到沒有剩下的工作
+void *worker(void *w)
+{
+  jmp_buf jb;
+  int j;
+
+  alist = malloc(Amax * 2 * sizeof(int)); alend = alist + Amax * 2;
+  while ((j = take((int)w)) >= 0) {
+    alp = alist; jfail = &jb;
+    if (setjmp(jb)) bcode[j] = jcode; else bcode[j] = run(bargc[j], bargv[j]);
+    jfail = 0;
+    while (alp > alist) { alp = alp - 2; munmap((char *)*alp, alp[1]); }
   }
+  alp = 0; free(alist);
+  return 0;
+}
+
+// Run the jobs in file `jobs`. Print each job's exit code in job order at // 執行 `jobs` 檔案中的工作. 最後依工作順序印出每個工作的離開代碼
+// the end, and return 0 if all of them are 0, else 1. // 全部為 0 時回傳 0, 否則回傳 1
+int batch(char *jobs)
+{
+  char *b, *s, *t, **v;
+  int fd, n, i, c, nj, status;
+  pthread_t *th;
+
+  // Read the job file. // 讀取工作檔案
+  if ((fd = open(jobs, 0)) < 0) { printf("could not open(%s)\n", jobs); return -1; }
+  if ((n = lseek(fd, 0, SEEK_END)) < 0 || lseek(fd, 0, SEEK_SET) < 0 || !(b = malloc(n + 1))) { printf("could not read(%s)\n", jobs); return -1; }
+  i = 0; while (i < n && (c = read(fd, b + i, n - i)) > 0) i = i + c;
+  close(fd);
+  b[i] = 0;
+
+  // Split each line into its words in place, giving every job an `argv`. // 將每一行就地切成單字, 為每個工作建立 `argv`
+  c = 1; s = b; while (*s) if (*s++ == '\n') ++c;
+  bargv = malloc(c * sizeof(char **)); bargc = malloc(c * sizeof(int)); bcode = malloc(c * sizeof(int));
+  nj = 0; s = b;
+  while (*s) {
+    t = s; while (*t && *t != '\n') ++t;
+    v = malloc(((t - s) / 2 + 2) * sizeof(char *));
+    while (*s == ' ' || *s == '\t') ++s;
+    c = *s != '#' ? split(s, t, v) : 0;
+    if (c) { bargc[nj] = c; bargv[nj++] = v; } else free(v);
+    s = t; if (*s) *s++ = 0;
+  }
+
+  // Give each worker an equal share of the jobs and start it. // 給每個工作執行緒相同份量的工作並啟動它
+  if (nthread < 1) nthread = sysconf(_SC_NPROCESSORS_ONLN);
+  if (nthread > nj) nthread = nj;
+  if (nthread < 1) nthread = 1;
+  qlo = malloc(nthread * sizeof(int)); qhi = malloc(nthread * sizeof(int));
+  qmu = malloc(nthread * sizeof(pthread_mutex_t)); th = malloc(nthread * sizeof(pthread_t));
+  i = 0;
+  while (i < nthread) {
+    qlo[i] = nj * i / nthread; qhi[i] = nj * (i + 1) / nthread;
+    pthread_mutex_init(qmu + i, 0);
+    ++i;
+  }
+  i = 0;
+  while (i < nthread) {
+    if (pthread_create(th + i, 0, worker, (void *)i)) { printf("could not create thread\n"); return -1; }
+    ++i;
+  }
+  i = 0; while (i < nthread) pthread_join(th[i++], 0);
+
+  // Report the jobs. // 回報工作結果
+  status = 0; i = 0;
+  while (i < nj) {
+    printf("job %d: %s: exit(%d)\n", i + 1, *bargv[i], bcode[i]);
+    if (bcode[i]) status = 1;
+    ++i;
+  }
+  return status;
+}
+#else
+// No threads for c4 itself. // c4 本身沒有執行緒
+int batch(char *jobs)
+{
+  printf("--batch is only supported by host builds\n"); return -1;
+}
+#endif
+
+int main(int argc, char **argv)
+{
+  char *jobs; // `--batch` job file // `--batch` 的工作清單檔案
+  int i;
+
+  // Decrement `argc` to get the number of command line arguments. // 遞減 `argc` 取得參數數量
+  // Increment `argv` to point to the first command line argument. // 遞增 `argv` 指向第一個參數
+  --argc; ++argv;
+
+  // Opcode names for listings, in opcode order. // 列印用的操作碼名稱, 依操作碼順序排列
+  opname = "LEA ,IMM ,JMP ,JSR ,BZ  ,BNZ ,ENT ,ADJ ,TJSR,JTAB,"
+           "LLI ,SLI ,LGI ,SGI ,ADDI,BEQ ,BNE ,BLT ,BGT ,BLE ,BGE ,"
+           "LEV ,LI  ,LC  ,SI  ,SC  ,PSH ,"
+           "OR  ,XOR ,AND ,EQ  ,NE  ,LT  ,GT  ,LE  ,GE  ,SHL ,SHR ,ADD ,SUB ,MUL ,DIV ,MOD ,"
+           "OPEN,READ,CLOS,PRTF,MALC,FREE,MSET,MCMP,MCPY,MCHR,SLEN,SCMP,SCHR,"
+           "MMAP,LSEK,WRIT,MUNM,FSTA,MRST,EXIT,";
+
+  // Character classes for `next`; `ccls` is indexed from -128 so that a // `next` 使用的字元類別; `ccls` 從 -128 開始索引,
+  // signed `char` needs no masking. // 所以有號的 `char` 不需要遮罩
+  ccls = (char *)malloc(256) + 128; memset(ccls - 128, Cnone, 256);
+  ccls[' '] = ccls[9] = ccls[11] = ccls[12] = ccls[13] = Cspace; // tab, vertical tab, form feed, carriage return // 定位、垂直定位、換頁、歸位
+  i = 'a'; while (i <= 'z') { ccls[i] = ccls[i - 'a' + 'A'] = Cident; ++i; }
+  ccls['_'] = Cident;
+  i = '0'; while (i <= '9') ccls[i++] = Cdigit;
+
+  // Default area sizes; they are only reserved, so they can be generous. // 預設的區域大小; 只是保留位址空間, 所以可以大方一些
+  tsz = 16 << 20; dsz = 16 << 20; ssz = 8 << 20; ysz = 4 << 20; osz = 1 << 20; hsz = 256 << 20;
+  jobs = 0;
+
+  // Parse options until the source code file path. // 解析選項直到原始碼檔案路徑
+  while (argc > 0 && **argv == '-') {
+    // If command line argument `-s` is given, // 若指定 `-s` 參數
+    // turn on switch for printing source code line and corresponding // 開啟印出原始碼與對應指令的開關
+    // instructions. // 印出對應的虛擬機指令
+    if ((*argv)[1] == 's') src = 1;
+    // If command line argument `-d` is given, // 若指定 `-d` 參數
+    // turn on debug switch. // 開啟除錯模式
+    else if ((*argv)[1] == 'd') debug = 1;
+    // If command line argument `-j` is given, // 若指定 `-j` 參數
+    // compile to native code instead of interpreting. // 編譯成原生機器碼執行, 而不是解譯
+    else if ((*argv)[1] == 'j') jit = 1;
+    // If command line argument `-O` is given, // 若指定 `-O` 參數
+    // optimize each function after it is generated and inline small leaf // 在每個函數產生後進行最佳化,
+    // functions once the program is compiled. // 並在程式編譯完後內嵌展開小型葉函數
+    else if ((*argv)[1] == 'O') opt = 1;
+    // If command line argument `-r` is given, // 若指定 `-r` 參數
+    // run on the register VM. // 在暫存器虛擬機上執行
+    else if ((*argv)[1] == 'r') regvm = 1;
+    // If command line argument `-p` is given, // 若指定 `-p` 參數
+    // profile execution and print a report at exit. // 剖析執行並在結束時印出報告
+    else if ((*argv)[1] == 'p') prof = 1;
+    // If command line argument `-m` is given, // 若指定 `-m` 參數
+    // allocate the program's memory from a pooled heap of `--heap-size` bytes. // 從 `--heap-size` 位元組的記憶體池配置程式的記憶體
+    else if ((*argv)[1] == 'm') heap = 1;
+    // If command line argument `-l` is given, // 若指定 `-l` 參數
+    // count executions per source line and print the annotated source at exit. // 計算每個原始碼行的執行次數並在結束時印出附註的原始碼
+    else if ((*argv)[1] == 'l') lines = 1;
+    // If command line argument `-o file` is given, // 若指定 `-o file` 參數
+    // write a bytecode image to the file instead of running. // 將位元組碼映像寫入檔案而不執行
+    else if ((*argv)[1] == 'o' && argc > 1) { --argc; out = *++argv; }
+    // If command line argument `--stats` is given, // 若指定 `--stats` 參數
+    // print compile statistics before running. // 在執行前印出編譯統計
+    else if (!memcmp(*argv, "--stats", 8)) stats = 1;
+    // If command line argument `--diff` is given, run on both VMs and // 若指定 `--diff` 參數, 在兩種虛擬機上執行,
+    // compare their output, exit code and globals. // 並比較其輸出、離開代碼和全域變數
+    else if (!memcmp(*argv, "--diff", 7)) diff = 1;
+    // Area sizes: `--text-size`, `--data-size`, `--stack-size` and // 區域大小: `--text-size`, `--data-size`, `--stack-size` 和
+    // `--sym-size` take a size in bytes, with an optional k, m or g suffix. // `--sym-size` 接受以位元組為單位的大小, 可加上 k, m 或 g 字尾
+    // `--out-size` is the guest output buffer's; 1 writes every byte at once. // `--out-size` 是客體程式輸出緩衝區的大小; 1 表示每個位元組立即寫出
+    else if (argc > 1 && !memcmp(*argv, "--text-size", 12))  { --argc; tsz = argsize(*++argv); }
+    else if (argc > 1 && !memcmp(*argv, "--data-size", 12))  { --argc; dsz = argsize(*++argv); }
+    else if (argc > 1 && !memcmp(*argv, "--stack-size", 13)) { --argc; ssz = argsize(*++argv); }
+    else if (argc > 1 && !memcmp(*argv, "--sym-size", 11))   { --argc; ysz = argsize(*++argv); }
+    else if (argc > 1 && !memcmp(*argv, "--out-size", 11))   { --argc; osz = argsize(*++argv); }
+    else if (argc > 1 && !memcmp(*argv, "--heap-size", 12))  { --argc; hsz = argsize(*++argv); }
+    // If command line argument `--batch jobs` is given, run the jobs listed // 若指定 `--batch jobs` 參數, 以 `--threads` 個執行緒
+    // in the file on `--threads` threads (default one per core). // (預設每個核心一個) 執行檔案中列出的工作
+    else if (argc > 1 && !memcmp(*argv, "--batch", 8))       { --argc; jobs = *++argv; }
+    else if (argc > 1 && !memcmp(*argv, "--threads", 10))    { --argc; nthread = argsize(*++argv); }
+    // If command line argument `--serve path` is given, compile once and // 若指定 `--serve path` 參數, 只編譯一次,
+    // run the program for each request on Unix socket `path`. // 並為 Unix socket `path` 上的每個請求執行程式
+    else if (argc > 1 && !memcmp(*argv, "--serve", 8))       { --argc; sock = *++argv; }
+    // Unknown option, print program usage and exit program. // 不明選項, 印出使用方式後結束
+    else { printf("usage: c4 [-s] [-d] [-j] [-O] [-r] [-p] [-l] [-m] [-o image] [--stats] [--diff] [--text-size n] [--data-size n] [--stack-size n] [--sym-size n] [--out-size n] [--heap-size n] file ...\n"
+                  "       c4 [options] [--threads n] --batch jobs\n"
+                  "       c4 [options] --serve socket file\n"); return -1; }
+    --argc; ++argv;
+  }
+
+  // If neither a source code file path nor `--batch` is given or an area is // 若沒指定原始碼檔案也沒指定 `--batch`, 或區域太小，印出使用方式後結束
+  // too small, print program usage and exit program. // 結束程式
+  if ((argc < 1 && !jobs) || tsz < 64 << 10 || dsz < 64 << 10 || ssz < 64 << 10 || ysz < 64 << 10 || osz < 1 || hsz < 64 << 10) { printf("usage: c4 [-s] [-d] [-j] [-O] [-r] [-p] [-l] [-m] [-o image] [--stats] [--diff] [--text-size n] [--data-size n] [--stack-size n] [--sym-size n] [--out-size n] [--heap-size n] file ...\n"
+                  "       c4 [options] [--threads n] --batch jobs\n"
+                  "       c4 [options] --serve socket file\n"); return -1; }
+
+  // Run the `--batch` jobs, or the program in the source code file. // 執行 `--batch` 的工作, 或原始碼檔案中的程式
+  if (jobs) return batch(jobs);
+  return run(argc, argv);
 }